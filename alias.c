@@ -184,8 +184,7 @@ remove_alias (const char *name)
   if (elt)
     {
       free_alias_data (elt->data);
-      free (elt->key);		/* alias name */
-      free (elt);		/* XXX */
+      hash_dispose_item (elt);
 #if defined (PROGRAMMABLE_COMPLETION)
       set_itemlist_dirty (&it_aliases);
 #endif
@@ -61,6 +61,19 @@
 		ae->next = new; \
 	} while (0)
 
+/* Number of elements allocated at a time from the element pool. */
+#define AEPOOL_CHUNK	128
+
+/*
+ * Array elements come from a pool, since building and discarding arrays
+ * creates and frees elements one at a time.  Elements must be created with
+ * array_create_element and freed with array_dispose_element.
+ */
+sh_obj_pool_t aepool = OPOOL_INITIALIZER (AEPOOL_CHUNK);
+
+#define aealloc(e)	opool_alloc (aepool, ARRAY_ELEMENT, e)
+#define aefree(e)	opool_free (aepool, ARRAY_ELEMENT, e)
+
 static char *array_to_string_internal (ARRAY_ELEMENT *, ARRAY_ELEMENT *, char *, int);
 
 static char *spacesep = " ";
@@ -87,6 +100,7 @@ array_create(void)
 	r->max_index = -1;
 	r->num_elements = 0;
 	r->lastref = (ARRAY_ELEMENT *)0;
+	r->refs = (int *)0;
 	head = array_create_element(-1, (char *)NULL);	/* dummy head */
 	head->prev = head->next = head;
 	r->head = head;
@@ -100,6 +114,18 @@ array_flush (ARRAY *a)
 
 	if (a == 0)
 		return;
+	if (a->refs && *a->refs > 1) {
+		/* Leave the shared elements to the other arrays */
+		(*a->refs)--;
+		a->refs = (int *)0;
+		a->head = array_create_element(-1, (char *)NULL);
+		a->head->prev = a->head->next = a->head;
+		a->max_index = -1;
+		a->num_elements = 0;
+		INVALIDATE_LASTREF(a);
+		return;
+	}
+	ARRAY_UNSHARE(a);
 	for (r = element_forw(a->head); r != a->head; ) {
 		r1 = element_forw(r);
 		array_dispose_element(r);
@@ -116,31 +142,68 @@ array_dispose(ARRAY *a)
 {
 	if (a == 0)
 		return;
+	if (a->refs && *a->refs > 1) {
+		(*a->refs)--;
+		free(a);
+		return;
+	}
 	array_flush (a);
 	array_dispose_element(a->head);
 	free(a);
 }
 
+/*
+ * Return a copy of array A.  The copy shares A's elements, and the first
+ * change to either array gives it its own copy of them (array_unshare), so
+ * copies that are never modified cost no more than the ARRAY itself.
+ */
 ARRAY *
 array_copy(ARRAY *a)
 {
 	ARRAY	*a1;
-	ARRAY_ELEMENT	*ae, *new;
 
 	if (a == 0)
 		return((ARRAY *) NULL);
-	a1 = array_create();
-	a1->max_index = a->max_index;
-	a1->num_elements = a->num_elements;
-	for (ae = element_forw(a->head); ae != a->head; ae = element_forw(ae)) {
-		new = array_create_element(element_index(ae), element_value(ae));
-		ADD_BEFORE(a1->head, new);
-		if (ae == LASTREF(a))
-			SET_LASTREF(a1, new);
+	if (a->refs == 0) {
+		a->refs = (int *)xmalloc(sizeof(int));
+		*a->refs = 1;
 	}
+	a1 = (ARRAY *)xmalloc(sizeof(ARRAY));
+	*a1 = *a;
+	(*a->refs)++;
 	return(a1);
 }
 
+/*
+ * If A shares its elements with other arrays, give it a private copy of
+ * them before it is modified.  If the other arrays have all been disposed,
+ * A simply takes ownership of the elements.
+ */
+void
+array_unshare(ARRAY *a)
+{
+	ARRAY_ELEMENT	*head, *ae, *new, *lastref;
+
+	if (a == 0 || a->refs == 0)
+		return;
+	if (*a->refs > 1) {
+		(*a->refs)--;
+		head = array_create_element(-1, (char *)NULL);
+		head->prev = head->next = head;
+		lastref = (ARRAY_ELEMENT *)0;
+		for (ae = element_forw(a->head); ae != a->head; ae = element_forw(ae)) {
+			new = array_create_element(element_index(ae), element_value(ae));
+			ADD_BEFORE(head, new);
+			if (ae == a->lastref)
+				lastref = new;
+		}
+		a->head = head;
+		a->lastref = lastref;
+	} else
+		free(a->refs);
+	a->refs = (int *)0;
+}
+
 /*
  * Make and return a new array composed of the elements in array A from
  * S to E, inclusive.
@@ -198,6 +261,7 @@ array_shift(ARRAY *a, int n, int flags)
 	if (a == 0 || array_empty(a) || n <= 0)
 		return ((ARRAY_ELEMENT *)NULL);
 
+	ARRAY_UNSHARE(a);
 	INVALIDATE_LASTREF(a);
 	for (i = 0, ret = ae = element_forw(a->head); ae != a->head && i < n; ae = element_forw(ae), i++)
 		;
@@ -257,6 +321,7 @@ array_rshift (ARRAY *a, int n, char *s)
 	else if (n <= 0)
 		return (a->num_elements);
 
+	ARRAY_UNSHARE(a);
 	ae = element_forw(a->head);
 	if (s) {
 		new = array_create_element(0, s);
@@ -300,6 +365,7 @@ array_quote(ARRAY *array)
 
 	if (array == 0 || array_head(array) == 0 || array_empty(array))
 		return (ARRAY *)NULL;
+	ARRAY_UNSHARE(array);
 	for (a = element_forw(array->head); a != array->head; a = element_forw(a)) {
 		t = quote_string (a->value);
 		FREE(a->value);
@@ -316,6 +382,7 @@ array_quote_escapes(ARRAY *array)
 
 	if (array == 0 || array_head(array) == 0 || array_empty(array))
 		return (ARRAY *)NULL;
+	ARRAY_UNSHARE(array);
 	for (a = element_forw(array->head); a != array->head; a = element_forw(a)) {
 		t = quote_escapes (a->value);
 		FREE(a->value);
@@ -332,6 +399,7 @@ array_dequote(ARRAY *array)
 
 	if (array == 0 || array_head(array) == 0 || array_empty(array))
 		return (ARRAY *)NULL;
+	ARRAY_UNSHARE(array);
 	for (a = element_forw(array->head); a != array->head; a = element_forw(a)) {
 		t = dequote_string (a->value);
 		FREE(a->value);
@@ -348,6 +416,7 @@ array_dequote_escapes(ARRAY *array)
 
 	if (array == 0 || array_head(array) == 0 || array_empty(array))
 		return (ARRAY *)NULL;
+	ARRAY_UNSHARE(array);
 	for (a = element_forw(array->head); a != array->head; a = element_forw(a)) {
 		t = dequote_escapes (a->value);
 		FREE(a->value);
@@ -363,6 +432,7 @@ array_remove_quoted_nulls(ARRAY *array)
 
 	if (array == 0 || array_head(array) == 0 || array_empty(array))
 		return (ARRAY *)NULL;
+	ARRAY_UNSHARE(array);
 	for (a = element_forw(array->head); a != array->head; a = element_forw(a))
 		a->value = remove_quoted_nulls (a->value);
 	return array;
@@ -484,7 +554,7 @@ array_create_element(arrayind_t indx, char *value)
 {
 	ARRAY_ELEMENT *r;
 
-	r = (ARRAY_ELEMENT *)xmalloc(sizeof(ARRAY_ELEMENT));
+	aealloc(r);
 	r->ind = indx;
 	r->value = value ? savestring(value) : (char *)NULL;
 	r->next = r->prev = (ARRAY_ELEMENT *) NULL;
@@ -505,7 +575,7 @@ array_dispose_element(ARRAY_ELEMENT *ae)
 {
 	if (ae) {
 		FREE(ae->value);
-		free(ae);
+		aefree(ae);
 	}
 }
 
@@ -521,6 +591,7 @@ array_insert(ARRAY *a, arrayind_t i, char *v)
 
 	if (a == 0)
 		return(-1);
+	ARRAY_UNSHARE(a);
 	new = array_create_element(i, v);
 	if (i > array_max_index(a)) {
 		/*
@@ -609,6 +680,7 @@ array_remove(ARRAY *a, arrayind_t i)
 		return((ARRAY_ELEMENT *) NULL);
 	if (i > array_max_index(a) || i < array_first_index(a))
 		return((ARRAY_ELEMENT *)NULL);	/* Keep roving pointer into array to optimize sequential access */
+	ARRAY_UNSHARE(a);
 	start = LASTREF(a);
 	/* Use same strategy as array_reference to avoid paying large penalty
 	   for semi-random assignment pattern. */
@@ -818,6 +890,8 @@ array_from_argv(ARRAY *a, char **vec, int count)
       return a;
     }
 
+  ARRAY_UNSHARE (a);
+
   /* Fast case */
   if (array_num_elements (a) == count && count == 1)
     {
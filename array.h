@@ -37,6 +37,7 @@ typedef struct array {
 #else
 	struct array_element *head;
 	struct array_element *lastref;
+	int	*refs;		/* arrays sharing HEAD, or NULL if not shared */
 #endif
 } ARRAY;
 
@@ -64,6 +65,9 @@ extern void	array_flush (ARRAY *);
 extern void	array_dispose (ARRAY *);
 extern ARRAY	*array_copy (ARRAY *);
 #ifndef ALT_ARRAY_IMPLEMENTATION
+extern void	array_unshare (ARRAY *);
+#endif
+#ifndef ALT_ARRAY_IMPLEMENTATION
 extern ARRAY	*array_slice (ARRAY *, ARRAY_ELEMENT *, ARRAY_ELEMENT *);
 #else
 extern ARRAY	*array_slice (ARRAY *, arrayind_t, arrayind_t);
@@ -144,6 +148,19 @@ extern arrayind_t element_back (ARRAY *, arrayind_t);
 
 #define set_element_value(ae, val)	((ae)->value = (val))
 
+/* Arrays made by array_copy share their elements with the original until
+   one of them is modified.  Code that changes an array's elements without
+   going through the functions in array.c must unshare it first. */
+#ifndef ALT_ARRAY_IMPLEMENTATION
+#define ARRAY_UNSHARE(a) \
+  do { \
+    if ((a) && (a)->refs) \
+      array_unshare (a); \
+  } while (0)
+#else
+#define ARRAY_UNSHARE(a)
+#endif
+
 #ifdef ALT_ARRAY_IMPLEMENTATION
 #define set_first_index(a, i)	((a)->first_index = (i))
 #endif
@@ -172,8 +172,7 @@ make_array_variable_value (SHELL_VAR *entry, arrayind_t ind, const char *key, co
      fake out make_variable_value with a dummy SHELL_VAR */
   if (flags & ASS_APPEND)
     {
-      dentry = (SHELL_VAR *)xmalloc (sizeof (SHELL_VAR));
-      dentry->name = savestring (entry->name);
+      dentry = new_shell_variable (entry->name);
       if (assoc_p (entry))
 	newval = assoc_reference (assoc_cell (entry), key);
       else
@@ -187,8 +186,6 @@ make_array_variable_value (SHELL_VAR *entry, arrayind_t ind, const char *key, co
 	}
       dentry->exportstr = 0;
       dentry->attributes = entry->attributes & ~(att_array|att_assoc|att_exported);
-      /* Leave the rest of the members uninitialized; the code doesn't look
-	 at them. */
       newval = make_variable_value (dentry, value, flags);	 
       dispose_variable (dentry);
     }
@@ -48,11 +48,66 @@ static WORD_LIST *assoc_to_word_list_internal (HASH_TABLE *, int);
 
 /* assoc_create == hash_create */
 
+/* Return a copy of HASH.  The copy shares HASH's elements, and the first
+   change to either table gives it its own copy of them (assoc_unshare), so
+   copies that are never modified cost no more than the table header. */
+HASH_TABLE *
+assoc_copy (HASH_TABLE *hash)
+{
+  HASH_TABLE *new_table;
+
+  if (hash == 0)
+    return ((HASH_TABLE *)NULL);
+
+  if (hash->refs == 0)
+    {
+      hash->refs = (int *)xmalloc (sizeof (int));
+      *hash->refs = 1;
+    }
+  new_table = (HASH_TABLE *)xmalloc (sizeof (HASH_TABLE));
+  *new_table = *hash;
+  (*hash->refs)++;
+
+  return new_table;
+}
+
+/* If HASH shares its elements with other tables, give it a private copy
+   of them before it is modified.  If the other tables have all been
+   disposed, HASH simply takes ownership of the elements. */
+void
+assoc_unshare (HASH_TABLE *hash)
+{
+  HASH_TABLE *t;
+
+  if (hash == 0 || hash->refs == 0)
+    return;
+
+  if (*hash->refs > 1)
+    {
+      t = hash_copy (hash, 0);
+      (*hash->refs)--;
+      hash->bucket_array = t->bucket_array;
+      hash->nbuckets = t->nbuckets;
+      hash->nentries = t->nentries;
+      free (t);
+    }
+  else
+    free (hash->refs);
+  hash->refs = (int *)NULL;
+}
+
 void
 assoc_dispose (HASH_TABLE *hash)
 {
   if (hash)
     {
+      if (hash->refs && *hash->refs > 1)
+	{
+	  (*hash->refs)--;
+	  free (hash);
+	  return;
+	}
+      FREE (hash->refs);
       hash_flush (hash, 0);
       hash_dispose (hash);
     }
@@ -61,6 +116,20 @@ assoc_dispose (HASH_TABLE *hash)
 void
 assoc_flush (HASH_TABLE *hash)
 {
+  int i;
+
+  if (hash && hash->refs && *hash->refs > 1)
+    {
+      /* Leave the shared elements to the other tables */
+      (*hash->refs)--;
+      hash->refs = (int *)NULL;
+      hash->bucket_array = (BUCKET_CONTENTS **)xmalloc (hash->nbuckets * sizeof (BUCKET_CONTENTS *));
+      for (i = 0; i < hash->nbuckets; i++)
+	hash->bucket_array[i] = (BUCKET_CONTENTS *)NULL;
+      hash->nentries = 0;
+      return;
+    }
+  assoc_unshare (hash);
   hash_flush (hash, 0);
 }
 
@@ -69,6 +138,7 @@ assoc_insert (HASH_TABLE *hash, char *key, char *value)
 {
   BUCKET_CONTENTS *b;
 
+  assoc_unshare (hash);
   b = hash_search (key, hash, HASH_CREATE);
   if (b == 0)
     return -1;
@@ -89,6 +159,7 @@ assoc_replace (HASH_TABLE *hash, char *key, char *value)
   BUCKET_CONTENTS *b;
   PTR_T t;
 
+  assoc_unshare (hash);
   b = hash_search (key, hash, HASH_CREATE);
   if (b == 0)
     return (PTR_T)0;
@@ -107,12 +178,12 @@ assoc_remove (HASH_TABLE *hash, const char *string)
 {
   BUCKET_CONTENTS *b;
 
+  assoc_unshare (hash);
   b = hash_remove (string, hash, 0);
   if (b)
     {
       free ((char *)b->data);
-      free (b->key);
-      free (b);
+      hash_dispose_item (b);
     }
 }
 
@@ -139,7 +210,8 @@ assoc_quote (HASH_TABLE *h)
 
   if (h == 0 || assoc_empty (h))
     return ((HASH_TABLE *)NULL);
-  
+
+  assoc_unshare (h);
   for (i = 0; i < h->nbuckets; i++)
     for (tlist = hash_items (i, h); tlist; tlist = tlist->next)
       {
@@ -162,7 +234,8 @@ assoc_quote_escapes (HASH_TABLE *h)
 
   if (h == 0 || assoc_empty (h))
     return ((HASH_TABLE *)NULL);
-  
+
+  assoc_unshare (h);
   for (i = 0; i < h->nbuckets; i++)
     for (tlist = hash_items (i, h); tlist; tlist = tlist->next)
       {
@@ -183,7 +256,8 @@ assoc_dequote (HASH_TABLE *h)
 
   if (h == 0 || assoc_empty (h))
     return ((HASH_TABLE *)NULL);
-  
+
+  assoc_unshare (h);
   for (i = 0; i < h->nbuckets; i++)
     for (tlist = hash_items (i, h); tlist; tlist = tlist->next)
       {
@@ -204,7 +278,8 @@ assoc_dequote_escapes (HASH_TABLE *h)
 
   if (h == 0 || assoc_empty (h))
     return ((HASH_TABLE *)NULL);
-  
+
+  assoc_unshare (h);
   for (i = 0; i < h->nbuckets; i++)
     for (tlist = hash_items (i, h); tlist; tlist = tlist->next)
       {
@@ -225,7 +300,8 @@ assoc_remove_quoted_nulls (HASH_TABLE *h)
 
   if (h == 0 || assoc_empty (h))
     return ((HASH_TABLE *)NULL);
-  
+
+  assoc_unshare (h);
   for (i = 0; i < h->nbuckets; i++)
     for (tlist = hash_items (i, h); tlist; tlist = tlist->next)
       {
@@ -32,10 +32,12 @@
 
 #define assoc_create(n)		(hash_create((n)))
 
-#define assoc_copy(h)		(hash_copy((h), 0))
 
 #define assoc_walk(h, f)	(hash_walk((h), (f))
 
+extern HASH_TABLE *assoc_copy (HASH_TABLE *);
+extern void assoc_unshare (HASH_TABLE *);
+
 extern void assoc_dispose (HASH_TABLE *);
 extern void assoc_flush (HASH_TABLE *);
 
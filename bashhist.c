@@ -49,6 +49,7 @@
 #include "parser.h"	/* for the struct dstack stuff. */
 #include "pathexp.h"	/* for the struct ignorevar stuff */
 #include "bashhist.h"	/* matching prototypes and declarations */
+#include "profile.h"
 #include "builtins/common.h"
 
 #include <readline/history.h>
@@ -338,6 +339,7 @@ load_history (void)
     {
       while (read_history (hf) == EINTR)	/* 0 on success */
 	QUIT;
+      shell_stats.history_reads++;
       /* We have read all of the lines from the history file, even if we
 	 read more lines than $HISTSIZE.  Remember the total number of lines
 	 we read so we don't count the last N lines as new over and over
@@ -471,6 +473,7 @@ maybe_append_history (char *filename)
       if (histlen > 0 && history_lines_this_session > histlen)
 	history_lines_this_session = histlen;	/* reset below anyway */
       result = append_history (history_lines_this_session, filename);
+      shell_stats.history_writes++;
       /* Pretend we already read these lines from the file because we just
 	 added them */
       history_lines_in_file += history_lines_this_session;
@@ -522,6 +525,7 @@ maybe_save_shell_history (void)
 	      /* history_lines_in_file = where_history () + history_base - 1; */
 	    }
 	  history_lines_this_session = 0;
+	  shell_stats.history_writes++;
 
 	  sv_histsize ("HISTFILESIZE");
 	}
@@ -728,16 +732,13 @@ hc_erasedups (char *line)
   HIST_ENTRY *temp;
   int r;
 
-  using_history ();
-  while (temp = previous_history ())
+  /* history_search_line uses an index, so we don't look at every entry */
+  while ((r = history_search_line (line)) >= 0)
     {
-      if (STREQ (temp->line, line))
-	{
-	  r = where_history ();
-	  temp = remove_history (r);
-	  if (temp)
-	    free_history_entry (temp);
-	}
+      temp = remove_history (r);
+      if (temp == 0)
+	break;
+      free_history_entry (temp);
     }
   using_history ();
 }
@@ -913,7 +914,8 @@ bash_add_history (char *line)
 	  if (dstack.delimiter_depth == 0 && curlen > 0 && current->line[curlen - 1] == '\\' &&
 	      (curlen < 2 || current->line[curlen - 2] != '\\'))
 	    {
-	      current->line[curlen - 1] = '\0';
+	      /* Don't modify the history entry in place; the history
+		 library indexes entries by their contents. */
 	      curlen--;
 	      chars_to_add = "";
 	    }
@@ -929,7 +931,7 @@ bash_add_history (char *line)
 				      + curlen
 				      + strlen (line)
 				      + strlen (chars_to_add));
-	  sprintf (new_line, "%s%s%s", current->line, chars_to_add, line);
+	  sprintf (new_line, "%.*s%s%s", (int)curlen, current->line, chars_to_add, line);
 	  offset = where_history ();
 	  old = replace_history_entry (offset, new_line, current->data);
 	  free (new_line);
@@ -962,6 +964,7 @@ really_add_history (char *line)
   hist_last_line_pushed = 0;
   add_history (line);
   history_lines_this_session++;
+  shell_stats.history_adds++;
 }
 
 int
@@ -2326,6 +2326,13 @@ globword:
       if (current_path[0] == '.' && current_path[1] == '\0')
 	dot_in_path = 1;
 
+      /* Skip directories the PATH index says can't contain a match. */
+      if (path_dir_has_prefix (current_path, dequoted_hint, igncase) == 0)
+	{
+	  free (current_path);
+	  goto outer;
+	}
+
       if (fnhint && fnhint != filename_hint)
 	free (fnhint);
       if (filename_hint)
@@ -3774,7 +3781,7 @@ build_history_completion_array (void)
 
       /* Sort the complete list of tokens. */
       if (harry_len > 1 && dabbrev_expand_active == 0)
-        qsort (history_completion_array, harry_len, sizeof (char *), (QSFUNC *)strvec_strcmp);
+        strvec_sort (history_completion_array, 0);
     }
 }
 
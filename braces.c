@@ -84,6 +84,9 @@ static int brace_gobbler (char *, size_t, int *, int *, int);
 static char **expand_amble (char *, size_t, int);
 static char **expand_seqterm (char *, size_t);
 static int valid_seqterm (char *, size_t);
+static int parse_seqterm (char *, size_t, intmax_t *, intmax_t *, intmax_t *, int *, size_t *);
+static int seq_nelem (intmax_t, intmax_t, intmax_t *, size_t *);
+static size_t seq_format (intmax_t, int, size_t, char *);
 static char **mkseq (intmax_t, intmax_t, intmax_t, int, size_t);
 static char **array_concat (char **, char **);
 
@@ -369,32 +372,84 @@ expand_amble (char *text, size_t tlen, int flags)
 #define ST_CHAR	2
 #define ST_ZINT	3
 
-static char **
-mkseq (intmax_t start, intmax_t end, intmax_t incr, int type, size_t width)
+/* Space needed to format an element of a sequence with minimum width WIDTH */
+#define SEQ_BUFSIZE(width)	((width) + INT_BUFSIZE_BOUND (intmax_t))
+
+/* Compute the number of elements in the sequence from START to END, plus
+   one for a trailing null, and store it in *NELEMP.  Make sure the sign of
+   *INCRP agrees with START and END.  Returns 0 on overflow. */
+static int
+seq_nelem (intmax_t start, intmax_t end, intmax_t *incrp, size_t *nelemp)
 {
-  intmax_t prevn, n, abs_incr;
-  size_t nelem, i;
-  char **result, *t;
-  char lbuf[INT_BUFSIZE_BOUND (uintmax_t)];
+  intmax_t prevn, incr, abs_incr;
 
+  incr = *incrp;
   if (incr == 0)
     incr = 1;
 
   abs_incr = incr;
   if (incr < 0 && ckd_sub (&abs_incr, 0, incr))
-    return ((char **)NULL);
+    return 0;
 
   /* Make sure incr agrees with start and end */
   if ((start < end) == (incr < 0) && ckd_sub (&incr, 0, incr))
-    return ((char **)NULL);
+    return 0;
 
   /* prevn = sh_imaxabs (end - start); */
   if (start < end ? ckd_sub (&prevn, end, start) : ckd_sub (&prevn, start, end))
-    return ((char **)NULL);
+    return 0;
 
   /* nelem = floor (abs ((end - start) / incr)) plus 1 for first element plus
      trailing null. Account for trailing null up here for overflow check */
-  if (ckd_add (&nelem, prevn / abs_incr, 2))
+  if (ckd_add (nelemp, prevn / abs_incr, 2))
+    return 0;
+
+  *incrp = incr;
+  return 1;
+}
+
+/* Format sequence element N of type TYPE into BUF, which has room for at
+   least SEQ_BUFSIZE (WIDTH) bytes, zero-padding integers to WIDTH
+   characters if TYPE is ST_ZINT.  Returns the length of the result. */
+static size_t
+seq_format (intmax_t n, int type, size_t width, char *buf)
+{
+  char nbuf[INT_BUFSIZE_BOUND (intmax_t)], *t;
+  size_t tlen, neg;
+
+  if (type == ST_CHAR)
+    {
+      buf[0] = n;
+      buf[1] = '\0';
+      return 1;
+    }
+
+  t = inttostr (n, nbuf, sizeof (nbuf));
+  tlen = strlen (t);
+  if (type == ST_ZINT && tlen < width)
+    {
+      /* zero-pad the result directly to avoid sprintf */
+      neg = (n < 0);
+      if (neg)
+	buf[0] = '-';
+      memset (buf + neg, '0', width - tlen);
+      memcpy (buf + neg + width - tlen, t + neg, tlen - neg + 1);
+      return width;
+    }
+
+  memcpy (buf, t, tlen + 1);
+  return tlen;
+}
+
+static char **
+mkseq (intmax_t start, intmax_t end, intmax_t incr, int type, size_t width)
+{
+  intmax_t n;
+  size_t nelem, i, tlen;
+  char **result, *t, *buf;
+  char lbuf[INT_BUFSIZE_BOUND (uintmax_t)];
+
+  if (seq_nelem (start, end, &incr, &nelem) == 0)
     return ((char **)NULL);
 
   result = strvec_mcreate (nelem);
@@ -404,6 +459,8 @@ mkseq (intmax_t start, intmax_t end, intmax_t incr, int type, size_t width)
       return ((char **)NULL);
     }
 
+  buf = (char *)xmalloc (SEQ_BUFSIZE (width));
+
   /* Make sure we go through the loop at least once, so {3..3} prints `3' */
   i = 0;
   n = start;
@@ -415,39 +472,13 @@ mkseq (intmax_t start, intmax_t end, intmax_t incr, int type, size_t width)
           result[i] = (char *)NULL;
           strvec_dispose (result);
           result = (char **)NULL;
+          free (buf);
         }
       QUIT;
 #endif
-      if (type == ST_INT)
-	t = itos (n);
-      else if (type == ST_ZINT)
-	{
-	  size_t tlen;
-
-	  t = itos (n);
-	  tlen = strlen (t);
-	  if (tlen < width)	/* zero-pad the result directly to avoid sprintf */
-	    {
-	      char *t0;
-	      t0 = t;
-	      t = realloc (t, width + 1);
-	      if (t == 0)
-		free (t0);
-	      else
-		{
-		  memmove (t + (width - tlen), t, tlen + 1);
-		  memset (t + (n < 0), '0', width - tlen);
-		}
-	    }
-	}
-      else
-	{
-	  if (t = (char *)malloc (2))
-	    {
-	      t[0] = n;
-	      t[1] = '\0';
-	    }
-	}
+      tlen = seq_format (n, type, width, buf);
+      if (t = (char *)malloc (tlen + 1))
+	memcpy (t, buf, tlen + 1);
 
       result[i++] = t;
 
@@ -461,6 +492,7 @@ mkseq (intmax_t start, intmax_t end, intmax_t incr, int type, size_t width)
 	  p = uinttostr (n, lbuf, sizeof (lbuf));
 	  internal_error (_("brace expansion: failed to allocate memory for `%s'"), p);
 	  strvec_dispose (result);
+	  free (buf);
 	  return ((char **)NULL);
 	}
 
@@ -471,6 +503,7 @@ mkseq (intmax_t start, intmax_t end, intmax_t incr, int type, size_t width)
     }
   while (1);
 
+  free (buf);
   result[i] = (char *)0;
   return (result);
 }
@@ -513,19 +546,23 @@ valid_seqterm (char *text, size_t tlen)
   return 1;
 }
 
-static char **
-expand_seqterm (char *text, size_t tlen)
+/* Parse the sequence expression TEXT (the text between the braces) into its
+   first and last values, increment, type (ST_INT, ST_ZINT, or ST_CHAR), and
+   zero-padding width.  Returns 0 if TEXT is not a valid sequence expression. */
+static int
+parse_seqterm (char *text, size_t tlen, intmax_t *startp, intmax_t *endp,
+	       intmax_t *incrp, int *typep, size_t *widthp)
 {
   char *t, *lhs, *rhs;
   int lhs_t, rhs_t;
   size_t lhs_l, rhs_l, width;
   intmax_t lhs_v, rhs_v, incr;
   intmax_t tl, tr;
-  char **result, *ep, *oep;
+  char *ep, *oep;
 
   t = strstr (text, BRACE_SEQ_SPECIFIER);
   if (t == 0)
-    return ((char **)NULL);
+    return 0;
 
   lhs_l = t - text;		/* index of start of BRACE_SEQ_SPECIFIER */
   lhs = substring (text, 0, lhs_l);
@@ -535,7 +572,7 @@ expand_seqterm (char *text, size_t tlen)
     {
       free (lhs);
       free (rhs);
-      return ((char **)NULL);
+      return 0;
     }
 
   /* Now figure out whether LHS and RHS are integers or letters.  Both
@@ -581,12 +618,11 @@ expand_seqterm (char *text, size_t tlen)
     {
       free (lhs);
       free (rhs);
-      return ((char **)NULL);
+      return 0;
     }
 
   /* OK, we have something.  It's either a sequence of integers, ascending
-     or descending, or a sequence or letters, ditto.  Generate the sequence,
-     put it into a string vector, and return it. */
+     or descending, or a sequence or letters, ditto. */
   
   if (lhs_t == ST_CHAR)
     {
@@ -617,14 +653,109 @@ expand_seqterm (char *text, size_t tlen)
         width = rhs_l;
     }
 
-  result = mkseq (lhs_v, rhs_v, incr, lhs_t, width);
-
   free (lhs);
   free (rhs);
 
-  return (result);
+  *startp = lhs_v;
+  *endp = rhs_v;
+  *incrp = incr;
+  *typep = lhs_t;
+  *widthp = width;
+  return 1;
 }
 
+/* Generate the sequence described by TEXT, put it into a string vector, and
+   return it. */
+static char **
+expand_seqterm (char *text, size_t tlen)
+{
+  intmax_t start, end, incr;
+  int type;
+  size_t width;
+
+  if (parse_seqterm (text, tlen, &start, &end, &incr, &type, &width) == 0)
+    return ((char **)NULL);
+
+  return (mkseq (start, end, incr, type, width));
+}
+
+#if defined (SHELL)
+/* Iterating over a sequence expression one element at a time, so callers
+   like the `for' command don't have to generate the entire sequence (which
+   can be very large) before using the first element. */
+struct brace_seqiter
+{
+  intmax_t n;		/* next element */
+  intmax_t incr;
+  size_t nleft;		/* number of elements not yet returned */
+  int type;
+  size_t width;
+  char buf[1];		/* the current element; SEQ_BUFSIZE(width) bytes */
+};
+
+/* If TEXT is a word consisting solely of a valid sequence expression, e.g.,
+   {1..10} or {01..100..3} or {a..z}, with no quoting and nothing else that
+   would be affected by later expansions, return an iterator over its
+   elements.  Otherwise, return NULL and let the caller perform brace
+   expansion as usual.  The iterator is a single block of memory that the
+   caller frees. */
+BRACE_SEQITER *
+brace_seqiter_create (const char *text)
+{
+  BRACE_SEQITER *sp;
+  char *amble;
+  size_t tlen, i, nelem, width;
+  intmax_t start, end, incr;
+  int type, r;
+
+  tlen = strlen (text);
+  if (tlen < 6 || text[0] != '{' || text[tlen - 1] != '}')
+    return ((BRACE_SEQITER *)NULL);
+  for (i = 1; i < tlen - 1; i++)
+    if (ISALNUM (text[i]) == 0 && text[i] != '.' && text[i] != '-' && text[i] != '+')
+      return ((BRACE_SEQITER *)NULL);
+
+  amble = substring (text, 1, tlen - 1);
+  r = valid_seqterm (amble, tlen - 2) &&
+	parse_seqterm (amble, tlen - 2, &start, &end, &incr, &type, &width);
+  free (amble);
+
+  if (r == 0 || seq_nelem (start, end, &incr, &nelem) == 0)
+    return ((BRACE_SEQITER *)NULL);
+
+  /* Sequences of letters can include characters that are special to later
+     expansions (e.g., {Z..a} includes `\'), so only handle those that stay
+     within the lowercase or uppercase ASCII letters. */
+  if (type == ST_CHAR &&
+	((start < 'a' || start > 'z' || end < 'a' || end > 'z') &&
+	 (start < 'A' || start > 'Z' || end < 'A' || end > 'Z')))
+    return ((BRACE_SEQITER *)NULL);
+
+  sp = (BRACE_SEQITER *)xmalloc (sizeof (BRACE_SEQITER) + SEQ_BUFSIZE (width));
+  sp->n = start;
+  sp->incr = incr;
+  sp->nleft = nelem - 1;
+  sp->type = type;
+  sp->width = width;
+  sp->buf[0] = '\0';
+  return sp;
+}
+
+/* Return the next element of the sequence SP in a buffer that's overwritten
+   on each call, or NULL if there are no more elements. */
+char *
+brace_seqiter_next (BRACE_SEQITER *sp)
+{
+  if (sp->nleft == 0)
+    return ((char *)NULL);
+
+  seq_format (sp->n, sp->type, sp->width, sp->buf);
+  if (--sp->nleft)
+    sp->n += sp->incr;		/* can't overflow; seq_nelem checked */
+  return (sp->buf);
+}
+#endif /* SHELL */
+
 /* Start at INDEX, and skip characters in TEXT. Set INDEX to the
    index of the character matching SATISFY.  This understands about
    quoting.  Return the character that caused us to stop searching;
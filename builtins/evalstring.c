@@ -468,11 +468,14 @@ parse_and_execute (char *string, const char *from_file, int flags)
 
 		  /* If the command parses to something other than a straight
 		     function definition, or if we have not consumed the entire
-		     string, or if the parser has transformed the function
-		     name (as parsing will if it begins or ends with shell
-		     whitespace, for example), reject the attempt */
+		     string (the rest of the current line or any lines after
+		     it that contain more than whitespace), or if the parser
+		     has transformed the function name (as parsing will if it
+		     begins or ends with shell whitespace, for example), reject
+		     the attempt */
 		  if (command->type != cm_function_def ||
 		      ((x = parser_remaining_input ()) && *x) ||
+		      bash_input.location.string[strspn (bash_input.location.string, " \t\n")] ||
 		      (STREQ (from_file, command->value.Function_def->name->word) == 0))
 		    {
 		      internal_warning (_("%s: ignoring function definition attempt"), from_file);
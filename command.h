@@ -253,8 +253,21 @@ typedef struct case_com {
   int line;			/* line number the `case' keyword appears on */
   WORD_DESC *word;		/* The thing to test. */
   PATTERN_LIST *clauses;	/* The clauses to test against, or NULL. */
+  struct case_dispatch *dispatch;	/* Lookup table for literal patterns */
 } CASE_COM;
 
+/* A table for finding the first clause of a case command that has a literal
+   pattern equal to the word being matched without testing each pattern in
+   turn.  Built by make_case_command and shared between copies of the
+   command, since shell functions are copied each time they're executed. */
+typedef struct case_dispatch {
+  int refcount;
+  int nclauses;
+  struct hash_table *literals;	/* literal pattern -> clause indices */
+  int *complex;			/* indices of clauses with patterns that aren't
+				   literals, in order, terminated by -1 */
+} CASE_DISPATCH;
+
 /* FOR command. */
 typedef struct for_com {
   int flags;		/* See description of CMD flags. */
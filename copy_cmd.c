@@ -241,6 +241,9 @@ copy_case_command (CASE_COM *com)
   new_case->line = com->line;
   new_case->word = copy_word (com->word);
   new_case->clauses = copy_case_clauses (com->clauses);
+  new_case->dispatch = com->dispatch;
+  if (new_case->dispatch)
+    new_case->dispatch->refcount++;
   return (new_case);
 }
 
@@ -106,6 +106,7 @@ dispose_command (COMMAND *command)
 
 	c = command->value.Case;
 	dispose_word (c->word);
+	dispose_case_dispatch (c->dispatch);
 
 	for (p = c->clauses; p; )
 	  {
@@ -243,6 +244,18 @@ dispose_function_def (FUNCTION_DEF *c)
   free (c);
 }
 
+/* Release a reference to the case command lookup table D. */
+void
+dispose_case_dispatch (CASE_DISPATCH *d)
+{
+  if (d == 0 || --d->refcount > 0)
+    return;
+  hash_flush (d->literals, (sh_free_func_t *)NULL);
+  hash_dispose (d->literals);
+  free (d->complex);
+  free (d);
+}
+
 /* How to free a WORD_DESC. */
 void
 dispose_word (WORD_DESC *w)
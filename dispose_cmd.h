@@ -29,6 +29,7 @@ extern void dispose_word (WORD_DESC *);
 extern void dispose_words (WORD_LIST *);
 extern void dispose_word_array (char **);
 extern void dispose_redirects (REDIRECT *);
+extern void dispose_case_dispatch (CASE_DISPATCH *);
 
 #if defined (COND_COMMAND)
 extern void dispose_cond_node (COND_COM *);
@@ -145,6 +145,9 @@ sort_inplace(SHELL_VAR *var)
     if ( n == 0 )
         return EXECUTION_SUCCESS;
 
+    // the elements are relinked below, so don't share them with copies
+    ARRAY_UNSHARE(a);
+
     sa = xmalloc(n * sizeof(sort_element));
 
     i = 0;
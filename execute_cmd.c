@@ -79,6 +79,7 @@ extern int errno;
 #include "trap.h"
 #include "pathexp.h"
 #include "hashcmd.h"
+#include "profile.h"
 
 #if defined (COND_COMMAND)
 #  include "test.h"
@@ -130,6 +131,8 @@ static void uw_restore_signal_mask (void *);
 
 static int builtin_status (int);
 
+static BRACE_SEQITER *for_sequence_iterator (WORD_LIST *);
+static inline WORD_LIST *for_next_word (WORD_LIST *, BRACE_SEQITER *);
 static int execute_for_command (FOR_COM *);
 #if defined (SELECT_COMMAND)
 static int displen (const char *);
@@ -157,6 +160,9 @@ static int time_command (COMMAND *, int, int, int, struct fd_bitmap *);
 static intmax_t eval_arith_for_expr (WORD_LIST *, int *);
 static int execute_arith_for_command (ARITH_FOR_COM *);
 #endif
+static int case_pattern_matches (WORD_DESC *, char *);
+static int case_clause_matches (PATTERN_LIST *, char *);
+static PATTERN_LIST *case_dispatch_match (CASE_DISPATCH *, char *, PATTERN_LIST *, int *);
 static int execute_case_command (CASE_COM *);
 static int execute_while_command (WHILE_COM *);
 static int execute_until_command (WHILE_COM *);
@@ -407,6 +413,18 @@ uw_restore_lineno (void *line)
   line_number = (intptr_t) line;
 }
 
+static void
+uw_profile_line_end (void *depth)
+{
+  profile_line_end ((intptr_t) depth);
+}
+
+static void
+uw_profile_leave (void *depth)
+{
+  profile_leave ((intptr_t) depth);
+}
+
 /* Return the line number of the currently executing command. */
 int
 executing_line_number (void)
@@ -698,6 +716,7 @@ execute_command_internal (COMMAND *command, int asynchronous, int pipe_in, int p
 	/* Otherwise we defer setting line_number */
       tcmd = make_command_string (command);
       fork_flags = asynchronous ? FORK_ASYNC : 0;
+      shell_stats.subshells++;
       paren_pid = make_child (p = savestring (tcmd), fork_flags);
 
       if (user_subshell && signal_is_trapped (ERROR_TRAP) && 
@@ -904,6 +923,8 @@ execute_command_internal (COMMAND *command, int asynchronous, int pipe_in, int p
     {
     case cm_simple:
       {
+	int pline;
+
 	save_line_number = line_number;
 	/* We can't rely on variables retaining their values across a
 	   call to execute_simple_command if a longjmp occurs as the
@@ -934,11 +955,16 @@ execute_command_internal (COMMAND *command, int asynchronous, int pipe_in, int p
 	  }
 
 	SET_LINE_NUMBER (command->value.Simple->line);
+	pline = profiling_enabled ? profile_line_start (command->value.Simple->line, command->value.Simple->words ? command->value.Simple->words->word->word : (char *)NULL) : 0;
+	if (pline)
+	  add_unwind_protect (uw_profile_line_end, (void *) (intptr_t) pline);
 	exec_result =
 	  execute_simple_command (command->value.Simple, pipe_in, pipe_out,
 				  asynchronous, fds_to_close);
 	line_number = save_line_number;
 	discard_unwind_frame ("simple_lineno");
+	if (pline)
+	  profile_line_end (pline);
 
 	/* The temporary environment should be used for only the simple
 	   command immediately following its definition. */
@@ -2984,12 +3010,40 @@ execute_connection (COMMAND *command, int asynchronous, int pipe_in, int pipe_ou
     } \
   while (0)
 
+/* If LIST, the words following `in' in a for command, is a single word
+   consisting only of a brace expansion sequence expression, return an
+   iterator over the sequence's elements. */
+static BRACE_SEQITER *
+for_sequence_iterator (WORD_LIST *list)
+{
+#if defined (BRACE_EXPANSION)
+  if (brace_expansion && list && list->next == 0 && (list->word->flags & W_NOBRACE) == 0)
+    return (brace_seqiter_create (list->word->word));
+#endif
+  return ((BRACE_SEQITER *)NULL);
+}
+
+/* Return the word list element for the next iteration of a for command.
+   If we're iterating over a sequence expression, there is only one element,
+   whose word is overwritten with the next member of the sequence. */
+static inline WORD_LIST *
+for_next_word (WORD_LIST *list, BRACE_SEQITER *seq)
+{
+#if defined (BRACE_EXPANSION)
+  if (seq)
+    return ((list->word->word = brace_seqiter_next (seq)) ? list : (WORD_LIST *)NULL);
+#endif
+  return (list->next);
+}
+
 /* Execute a FOR command.  The syntax is: FOR word_desc IN word_list;
    DO command; DONE */
 static int
 execute_for_command (FOR_COM *for_command)
 {
-  WORD_LIST *releaser, *list;
+  WORD_LIST *releaser, *list, seqlist;
+  WORD_DESC seqword;
+  BRACE_SEQITER *seq;
   SHELL_VAR *v;
   char *identifier;
   int retval, save_line_number;
@@ -3014,10 +3068,25 @@ execute_for_command (FOR_COM *for_command)
   loop_level++; interrupt_execution++; retain_fifos++;
   identifier = for_command->name->word;
 
-  list = releaser = expand_words_no_vars (for_command->map_list);
+  /* If the list is a single sequence expression like {1..1000000}, generate
+     the elements one at a time instead of expanding the entire list. */
+  seq = for_sequence_iterator (for_command->map_list);
+  if (seq)
+    {
+      seqword.word = brace_seqiter_next (seq);
+      seqword.flags = 0;
+      seqlist.word = &seqword;
+      seqlist.next = (WORD_LIST *)NULL;
+      list = &seqlist;
+      releaser = (WORD_LIST *)NULL;
+    }
+  else
+    list = releaser = expand_words_no_vars (for_command->map_list);
 
   begin_unwind_frame ("for");
   add_unwind_protect (uw_dispose_words, releaser);
+  if (seq)
+    add_unwind_protect (xfree, seq);
   add_unwind_protect (uw_restore_lineno, (void *) (intptr_t) save_line_number);
 
 #if 0
@@ -3032,7 +3101,7 @@ execute_for_command (FOR_COM *for_command)
   if (for_command->flags & CMD_IGNORE_RETURN)
     for_command->action->flags |= CMD_IGNORE_RETURN;
 
-  for (retval = EXECUTION_SUCCESS; list; list = list->next)
+  for (retval = EXECUTION_SUCCESS; list; list = for_next_word (list, seq))
     {
       QUIT;
 
@@ -3090,6 +3159,7 @@ execute_for_command (FOR_COM *for_command)
 	  else
 	    {
 	      dispose_words (releaser);
+	      FREE (seq);
 	      discard_unwind_frame ("for");
 	      loop_level--; interrupt_execution--; retain_fifos--;
 	      return (EXECUTION_FAILURE);
@@ -3139,6 +3209,7 @@ execute_for_command (FOR_COM *for_command)
 #endif
 
   dispose_words (releaser);
+  FREE (seq);
   discard_unwind_frame ("for");
   return (retval);
 }
@@ -3636,6 +3707,111 @@ execute_select_command (SELECT_COM *select_command)
 }
 #endif /* SELECT_COMMAND */
 
+/* Return non-zero if the case pattern PAT matches WORD. */
+static int
+case_pattern_matches (WORD_DESC *pat, char *word)
+{
+  WORD_LIST *es;
+  char *pattern;
+  int match, qflags;
+
+  es = expand_word_leave_quoted (pat, 0);
+
+  if (es && es->word && es->word->word && *(es->word->word))
+    {
+      /* Convert quoted null strings into empty strings. */
+      qflags = QGLOB_CVTNULL;
+
+      /* We left CTLESC in place quoting CTLESC and CTLNUL after the
+	 call to expand_word_leave_quoted; tell quote_string_for_globbing
+	 to remove those here. This works for both unquoted portions of
+	 the word (which call quote_escapes) and quoted portions
+	 (which call quote_string). */
+      qflags |= QGLOB_CTLESC;
+      pattern = quote_string_for_globbing (es->word->word, qflags);
+    }
+  else
+    {
+      pattern = (char *)xmalloc (1);
+      pattern[0] = '\0';
+    }
+
+  /* Since the pattern does not undergo quote removal (as per
+     Posix.2, section 3.9.4.3), the strmatch () call must be able
+     to recognize backslashes as escape characters. */
+  match = strmatch (pattern, word, FNMATCH_EXTFLAG|FNMATCH_IGNCASE) != FNM_NOMATCH;
+  free (pattern);
+
+  dispose_words (es);
+
+  /* sm_loop.c:GMATCH returns failure on interrupt_state or
+     terminating_signal, so we check for those here. */
+  QUIT;
+
+  return match;
+}
+
+/* Return non-zero if any of the patterns in CLAUSE matches WORD, testing
+   them in order. */
+static int
+case_clause_matches (PATTERN_LIST *clause, char *word)
+{
+  WORD_LIST *list;
+
+  for (list = clause->patterns; list; list = list->next)
+    if (case_pattern_matches (list->word, word))
+      return 1;
+  return 0;
+}
+
+/* Return the first clause of a case command with lookup table D, starting
+   with CLAUSES, whose index is *INDP, that has a pattern matching WORD, and
+   set *INDP to its index.  Returns NULL if there isn't one. */
+static PATTERN_LIST *
+case_dispatch_match (CASE_DISPATCH *d, char *word, PATTERN_LIST *clauses, int *indp)
+{
+  BUCKET_CONTENTS *b;
+  int *ind, *c, i, h, start;
+
+  /* The first clause at or after START with a literal pattern equal to WORD */
+  start = *indp;
+  h = d->nclauses;
+  if (b = hash_search (word, d->literals, 0))
+    {
+      ind = (int *)b->data;
+      for (i = 1; i <= ind[0]; i++)
+	if (ind[i] >= start)
+	  {
+	    h = ind[i];
+	    break;
+	  }
+    }
+
+  /* Clauses that need pattern matching and come before that one still get
+     tested in order, as do the clause's own patterns, so any expansions
+     happen just as they would without the table. */
+  for (i = start, c = d->complex; *c >= 0 && *c <= h; c++)
+    {
+      if (*c < start)
+	continue;
+      for ( ; i < *c; i++)
+	clauses = clauses->next;
+      if (case_clause_matches (clauses, word))
+	{
+	  *indp = i;
+	  return clauses;
+	}
+    }
+
+  if (h >= d->nclauses)
+    return ((PATTERN_LIST *)NULL);
+
+  for ( ; i < h; i++)
+    clauses = clauses->next;
+  *indp = h;
+  return clauses;
+}
+
 /* Execute a CASE command.  The syntax is: CASE word_desc IN pattern_list ESAC.
    The pattern_list is a linked list of pattern clauses; each clause contains
    some patterns to compare word_desc against, and an associated command to
@@ -3643,11 +3819,11 @@ execute_select_command (SELECT_COM *select_command)
 static int
 execute_case_command (CASE_COM *case_command)
 {
-  WORD_LIST *list;
-  WORD_LIST *wlist, *es;
   PATTERN_LIST *clauses;
-  char *word, *pattern;
-  int retval, match, ignore_return, save_line_number, qflags;
+  CASE_DISPATCH *d;
+  WORD_LIST *wlist;
+  char *word;
+  int retval, ignore_return, save_line_number, i;
 
   save_line_number = line_number;
   line_number = case_command->line;
@@ -3704,61 +3880,50 @@ execute_case_command (CASE_COM *case_command)
 
 #define EXIT_CASE()  goto exit_case_command
 
-  for (clauses = case_command->clauses; clauses; clauses = clauses->next)
+  /* Literal patterns match case-insensitively if nocasematch is set */
+  d = case_command->dispatch;
+  if (d && match_ignore_case == 0)
     {
-      QUIT;
-      for (list = clauses->patterns; list; list = list->next)
+      i = 0;
+      clauses = case_command->clauses;
+      while (clauses = case_dispatch_match (d, word, clauses, &i))
 	{
-	  es = expand_word_leave_quoted (list->word, 0);
-
-	  if (es && es->word && es->word->word && *(es->word->word))
-	    {
-	      /* Convert quoted null strings into empty strings. */
-	      qflags = QGLOB_CVTNULL;
-
-	      /* We left CTLESC in place quoting CTLESC and CTLNUL after the
-	      	 call to expand_word_leave_quoted; tell quote_string_for_globbing
-	      	 to remove those here. This works for both unquoted portions of
-		 the word (which call quote_escapes) and quoted portions
-		 (which call quote_string). */
-	      qflags |= QGLOB_CTLESC;
-	      pattern = quote_string_for_globbing (es->word->word, qflags);
-	    }
-	  else
-	    {
-	      pattern = (char *)xmalloc (1);
-	      pattern[0] = '\0';
-	    }
-
-	  /* Since the pattern does not undergo quote removal (as per
-	     Posix.2, section 3.9.4.3), the strmatch () call must be able
-	     to recognize backslashes as escape characters. */
-	  match = strmatch (pattern, word, FNMATCH_EXTFLAG|FNMATCH_IGNCASE) != FNM_NOMATCH;
-	  free (pattern);
-
-	  dispose_words (es);
-
-	  /* sm_loop.c:GMATCH returns failure on interrupt_state or
-	     terminating_signal, so we check for those here. */
 	  QUIT;
-
-	  if (match)
+	  while (1)
 	    {
-	      do
-		{
-		  if (clauses->action && ignore_return)
-		    clauses->action->flags |= CMD_IGNORE_RETURN;
-		  retval = execute_command (clauses->action);
-		}
-	      while ((clauses->flags & CASEPAT_FALLTHROUGH) && (clauses = clauses->next));
-	      if (clauses == 0 || (clauses->flags & CASEPAT_TESTNEXT) == 0)
-		EXIT_CASE ();
-	      else
+	      if (clauses->action && ignore_return)
+		clauses->action->flags |= CMD_IGNORE_RETURN;
+	      retval = execute_command (clauses->action);
+	      if ((clauses->flags & CASEPAT_FALLTHROUGH) == 0 || clauses->next == 0)
 		break;
+	      clauses = clauses->next;
+	      i++;
 	    }
+	  if ((clauses->flags & CASEPAT_TESTNEXT) == 0 || clauses->next == 0)
+	    EXIT_CASE ();
+	  clauses = clauses->next;
+	  i++;
+	}
+      EXIT_CASE ();
+    }
 
-	  QUIT;
+  for (clauses = case_command->clauses; clauses; clauses = clauses->next)
+    {
+      QUIT;
+      if (case_clause_matches (clauses, word))
+	{
+	  do
+	    {
+	      if (clauses->action && ignore_return)
+		clauses->action->flags |= CMD_IGNORE_RETURN;
+	      retval = execute_command (clauses->action);
+	    }
+	  while ((clauses->flags & CASEPAT_FALLTHROUGH) && (clauses = clauses->next));
+	  if (clauses == 0 || (clauses->flags & CASEPAT_TESTNEXT) == 0)
+	    EXIT_CASE ();
 	}
+
+      QUIT;
     }
 
 exit_case_command:
@@ -5177,10 +5342,11 @@ uw_function_misc_cleanup (void *ignore)
   function_misc_cleanup ();
 }
 
+
 static int
 execute_function (SHELL_VAR *var, WORD_LIST *words, int flags, struct fd_bitmap *fds_to_close, int async, int subshell)
 {
-  int return_val, result, lineno;
+  int return_val, result, lineno, pdepth;
   COMMAND *tc, *fc, *save_current;
   char *debug_trap, *error_trap, *return_trap;
 #if defined (ARRAY_VARS)
@@ -5366,6 +5532,12 @@ execute_function (SHELL_VAR *var, WORD_LIST *words, int flags, struct fd_bitmap
 
   from_return_trap = 0;
 
+  /* Time the call from here; the unwind-protect stops the clock before
+     the function's context is torn down, however the call ends. */
+  pdepth = profiling_enabled ? profile_enter (this_shell_function->name) : 0;
+  if (pdepth && subshell == 0)
+    add_unwind_protect (uw_profile_leave, (void *) (intptr_t) pdepth);
+
   return_catch_flag++;
   return_val = setjmp_nosigs (return_catch);
 
@@ -5426,6 +5598,8 @@ execute_function (SHELL_VAR *var, WORD_LIST *words, int flags, struct fd_bitmap
 	pop_args ();
     }
 #endif
+  if (subshell && pdepth)
+    profile_leave (pdepth);
 
   function_misc_cleanup ();
   return (result);
@@ -5818,6 +5992,7 @@ execute_disk_command (WORD_LIST *words, REDIRECT *redirects, char *command_line,
 
       maybe_make_export_env ();
       put_command_name_into_env (command);
+      shell_stats.execs++;
     }
   else if (command == 0 && notfound_str == 0)	/* make sure */
     init_notfound_str ();
@@ -5827,7 +6002,12 @@ execute_disk_command (WORD_LIST *words, REDIRECT *redirects, char *command_line,
   /* If we can get away without forking and there are no pipes to deal with,
      don't bother to fork, just directly exec the command. */
   if (nofork && pipe_in == NO_PIPE && pipe_out == NO_PIPE)
-    pid = 0;
+    {
+      /* The shell is about to be replaced; write the profile now. */
+      if (profiling_enabled)
+	profile_stop ();
+      pid = 0;
+    }
   else
     {
       fork_flags = async ? FORK_ASYNC : 0;
@@ -6129,6 +6309,7 @@ shell_execve (char *command, char **args, char **env)
   char sample[HASH_BANG_BUFSIZ];
   size_t larray;
 
+  xtrace_flush ();
   SETOSTYPE (0);		/* Some systems use for USG/POSIX semantics */
   execve (command, args, env);
   i = errno;			/* error from execve() */
@@ -6321,7 +6502,7 @@ execute_intern_function (WORD_DESC *name, FUNCTION_DEF *funcdef)
       name->word = t;
     }
 
-  var = find_function (name->word);
+  var = find_function_noimport (name->word);
   if (var && ASSIGN_DISALLOWED (var, 0))
     {
       if (readonly_p (var))
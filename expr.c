@@ -194,6 +194,7 @@ static struct lvalue *alloc_lvalue (void);
 static void	free_lvalue (struct lvalue *);
 
 static intmax_t	expr_streval (char *, int, struct lvalue *);
+static int	expr_decimal (const char *, intmax_t *);
 static intmax_t	strlong (char *);
 static void	evalerror (const char *);
 
@@ -512,6 +513,7 @@ expassign (void)
 {
   register intmax_t value;
   char *lhs, *rhs;
+  char ibuf[INT_STRLEN_BOUND (intmax_t) + 1];
   arrayind_t lind;
 #if defined (HAVE_IMAXDIV)
   imaxdiv_t idiv;
@@ -603,7 +605,7 @@ expassign (void)
 	  value = lvalue;
 	}
 
-      rhs = itos (value);
+      rhs = inttostr (value, ibuf, sizeof (ibuf));
       if (noeval == 0)
 	{
 #if defined (ARRAY_VARS)
@@ -616,7 +618,6 @@ expassign (void)
       if (curlval.tokstr && curlval.tokstr == tokstr)
 	init_lvalue (&curlval);
 
-      free (rhs);
       free (lhs);
       FREE (tokstr);
       tokstr = (char *)NULL;		/* For freeing on errors. */
@@ -1025,6 +1026,7 @@ exp0 (void)
 {
   intmax_t val, v2;
   char *vincdec;
+  char ibuf[INT_STRLEN_BOUND (intmax_t) + 1];
   int stok;
   EXPR_CONTEXT ec;
 
@@ -1040,7 +1042,7 @@ exp0 (void)
 	evalerror (_("identifier expected after pre-increment or pre-decrement"));
 
       v2 = tokval + ((stok == PREINC) ? 1 : -1);
-      vincdec = itos (v2);
+      vincdec = inttostr (v2, ibuf, sizeof (ibuf));
       if (noeval == 0)
 	{
 #if defined (ARRAY_VARS)
@@ -1051,7 +1053,6 @@ exp0 (void)
 	    if (tokstr)
 	      expr_bind_variable (tokstr, vincdec);
 	}
-      free (vincdec);
       val = v2;
 
       curtok = NUM;	/* make sure --x=7 is flagged as an error */
@@ -1093,7 +1094,7 @@ exp0 (void)
  	  lasttok = STR;	/* ec.curtok */
 
 	  v2 = val + ((stok == POSTINC) ? 1 : -1);
-	  vincdec = itos (v2);
+	  vincdec = inttostr (v2, ibuf, sizeof (ibuf));
 	  if (noeval == 0)
 	    {
 #if defined (ARRAY_VARS)
@@ -1103,7 +1104,6 @@ exp0 (void)
 #endif
 		expr_bind_variable (tokstr, vincdec);
 	    }
-	  free (vincdec);
 	  curtok = NUM;	/* make sure x++=7 is flagged as an error */
 	}
       else
@@ -1238,7 +1238,13 @@ expr_streval (char *tok, int e, struct lvalue *lvalue)
       return (0);
     }
 
-  tval = (value && *value) ? subexpr (value) : 0;
+  /* Integer variables, and most others used in arithmetic, hold a decimal
+     number as formatted by itos.  Convert those directly instead of
+     evaluating them as a subexpression. */
+  if (value == 0 || *value == 0)
+    tval = 0;
+  else if (expr_decimal (value, &tval) == 0)
+    tval = subexpr (value);
 
   if (lvalue)
     {
@@ -1255,6 +1261,45 @@ expr_streval (char *tok, int e, struct lvalue *lvalue)
   return (tval);
 }
 
+/* If STRING is a decimal integer in the canonical form itos produces: an
+   optional minus sign followed by digits with no leading zeros, short enough
+   that it cannot overflow, store its value in *RESULT and return 1.  Return
+   0 for anything else, including octal and base#n constants, and let the
+   evaluator handle it. */
+static int
+expr_decimal (const char *string, intmax_t *result)
+{
+  const char *s;
+  intmax_t val;
+  int neg;
+
+  s = string;
+  neg = (*s == '-');
+  if (neg)
+    s++;
+
+  if (*s == '0')
+    {
+      if (s[1] || neg)
+	return 0;
+      *result = 0;
+      return 1;
+    }
+
+  for (val = 0; DIGIT (*s); s++)
+    {
+      if (s - string >= 18 + neg)
+	return 0;
+      val = val * 10 + TODIGIT (*s);
+    }
+
+  if (*s || s == string + neg)
+    return 0;
+
+  *result = neg ? -val : val;
+  return 1;
+}
+
 static inline int
 is_multiop (int c)
 {
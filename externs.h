@@ -62,7 +62,10 @@ extern void xtrace_init (void);
 extern void xtrace_set (int, FILE *);
 #endif
 extern void xtrace_fdchk (int);
+extern void xtrace_fdflush (int);
 extern void xtrace_reset (void);
+extern void xtrace_set_options (int, int);
+extern void xtrace_flush (void);
 extern char *indirection_level_string (void);
 extern void xtrace_print_assignment (char *, char *, int, int);
 extern void xtrace_print_word_list (WORD_LIST *, int);
@@ -101,8 +104,12 @@ extern int parse_command (void);
 extern int read_command (void);
 
 /* Functions from braces.c. */
+typedef struct brace_seqiter BRACE_SEQITER;
+
 #if defined (BRACE_EXPANSION)
 extern char **brace_expand (char *);
+extern BRACE_SEQITER *brace_seqiter_create (const char *);
+extern char *brace_seqiter_next (BRACE_SEQITER *);
 #endif
 
 /* Miscellaneous functions from parse.y */
@@ -353,6 +360,7 @@ extern int sh_regmatch (const char *, const char *, int, char **);
 
 /* declarations for functions defined in lib/sh/shmbchar.c */
 extern size_t mbstrlen (const char *);
+extern size_t mbsasciispan (const char *);
 extern char *mbsmbchar (const char *);
 extern int sh_mbsnlen (const char *, size_t, int);
 
@@ -437,6 +445,13 @@ extern char **strvec_copy (char * const *);
 extern int strvec_posixcmp (char **, char **);
 extern int strvec_strcmp (char **, char **);
 extern void strvec_sort (char **, int);
+extern void strvec_reverse (char **);
+
+/* Flags for strvec_keysort */
+#define STRVEC_COLLATE	0x01	/* sort using the locale's collation order */
+#define STRVEC_POSIX	0x02	/* break collation ties bytewise */
+
+extern void strvec_keysort (void **, size_t, sh_strvec_key_func_t *, int);
 
 extern char **strvec_from_word_list (WORD_LIST *, int, int, int *);
 extern WORD_LIST *strvec_to_word_list (char **, int, int);
@@ -534,6 +549,7 @@ extern char *utf8_mbsmbchar (const char *);
 extern int utf8_mbsnlen (const char *, size_t, int);
 extern int utf8_mblen (const char *, size_t);
 extern size_t utf8_mbstrlen (const char *);
+extern size_t utf8_mbsadvance (const char *, size_t, size_t, size_t);
 
 /* declarations for functions defined in lib/sh/wcsnwidth.c */
 #if defined (HANDLE_MULTIBYTE)
@@ -28,12 +28,16 @@
 #endif
 #include "filecntl.h"
 #include "posixstat.h"
+#include "stat-time.h"
 
 #if defined (HAVE_UNISTD_H)
 #  include <unistd.h>
 #endif
 #include <errno.h>
 
+#include "posixdir.h"
+#include "posixtime.h"
+
 #include "bashansi.h"
 
 #include "memalloc.h"
@@ -51,6 +55,28 @@
 extern int errno;
 #endif
 
+/* A snapshot of the names in one directory in $PATH, used to answer
+   `is NAME in DIR?' without a stat(2) of DIR/NAME.  A snapshot is valid
+   as long as the directory's device, inode, and modification and change
+   times are unchanged and the change time is at least a full second older
+   than the snapshot.  A directory changed just before or while it was read
+   could change again without a visible change in its timestamp (coarse
+   filesystem timestamps, or a filesystem clock lagging the system clock),
+   so such snapshots are rebuilt on the next lookup instead. */
+typedef struct path_dir {
+  dev_t dev;
+  ino_t ino;
+  struct timespec mtime;
+  struct timespec ctime;	/* catches a modification time reset by touch */
+  time_t scanned;		/* when NAMES was read; 0 if never */
+  int probes;			/* lookups since the last scan */
+  int stale;			/* times a snapshot was found out of date */
+  int casefold;			/* directory ignores case in lookups */
+  int nnames;
+  char **names;			/* sorted with strcmp */
+  char *namebuf;
+} PATH_DIR;
+
 /* Static functions defined and used in this file. */
 static char *_find_user_command_internal (const char *, int);
 static char *find_user_command_internal (const char *, int);
@@ -60,6 +86,12 @@ static char *find_absolute_program (const char *, int);
 
 static char *get_next_path_element (char *, int *);
 
+static int path_dir_compare (const void *, const void *);
+static void path_dir_free (PTR_T);
+static int path_dir_scan (PATH_DIR *, const char *, struct stat *);
+static int path_dir_casefold (PATH_DIR *, const char *);
+static PATH_DIR *path_dir_lookup (const char *, int);
+
 /* The file name which we would try to execute, except that it isn't
    possible to execute it.  This is the first file that matches the
    name that we are looking for while we are searching $PATH for a
@@ -77,6 +109,23 @@ int check_hashed_filenames = CHECKHASH_DEFAULT;
    containing the file of interest. */
 int dot_found_in_search = 0;
 
+/* The PATH directory index, keyed by directory name as it appears in $PATH
+   (after tilde expansion). */
+static HASH_TABLE *path_dirs = (HASH_TABLE *)NULL;
+
+#define PATH_DIRS_BUCKETS	32
+
+/* A directory is read only after this many lookups have missed it, so short
+   scripts that run a handful of commands don't pay for readdir(3).  The
+   threshold doubles each time a directory's snapshot goes stale, up to
+   PATH_INDEX_MAXBACKOFF times, so a directory that keeps changing (`.' in
+   a script that writes files) isn't reread over and over. */
+#define PATH_INDEX_MINPROBES	4
+#define PATH_INDEX_MAXBACKOFF	8
+
+/* Set by `shopt pathcache'. */
+int path_index_enabled = PATH_INDEX_DEFAULT;
+
 /* Set up EXECIGNORE; a blacklist of patterns that executable files should not
    match. */
 static struct ignorevar execignore =
@@ -550,6 +599,17 @@ find_in_path_element (const char *name, char *path, int flags, size_t name_len,
   if (dot_found_in_search == 0 && *xpath == '.')
     dot_found_in_search = same_file (".", xpath, dotinfop, (struct stat *)NULL);
 
+  /* If the directory index knows NAME isn't in this directory, don't bother
+     looking at the file. */
+  if (path_dir_has_file (xpath, name) == 0)
+    {
+      if (xpath != path)
+	free (xpath);
+      if (rflagsp)
+	*rflagsp = 0;
+      return ((char *)NULL);
+    }
+
   full_path = sh_makepath (xpath, name, 0);
 
   status = file_status (full_path);
@@ -702,3 +762,286 @@ find_in_path (const char *name, char *path_list, int flags)
 {
   return (find_user_command_in_path (name, path_list, flags, (int *)0));
 }
+
+/* **************************************************************** */
+/*								    */
+/*		      The PATH Directory Index			    */
+/*								    */
+/* **************************************************************** */
+
+static int
+path_dir_compare (const void *a, const void *b)
+{
+  return (strcmp (*(char * const *)a, *(char * const *)b));
+}
+
+static void
+path_dir_free (PTR_T data)
+{
+  PATH_DIR *pd;
+
+  pd = (PATH_DIR *)data;
+  FREE (pd->names);
+  FREE (pd->namebuf);
+  free (pd);
+}
+
+/* Read the names in directory DIR, whose current status is in SBP, into PD.
+   Returns 0 on success and -1 if the directory can't be read completely. */
+static int
+path_dir_scan (PATH_DIR *pd, const char *dir, struct stat *sbp)
+{
+  DIR *d;
+  struct dirent *dp;
+  char *buf;
+  size_t blen, bsize, nlen, *offsets;
+  int n, nsize, i;
+  time_t now;
+
+  FREE (pd->names);
+  FREE (pd->namebuf);
+  pd->names = (char **)NULL;
+  pd->namebuf = (char *)NULL;
+  pd->nnames = 0;
+  pd->scanned = 0;
+
+  /* Take the time before reading, so anything added while we read has a
+     modification time no earlier than the scan. */
+  now = getnow ();
+  d = opendir (dir);
+  if (d == 0)
+    return -1;
+
+  buf = (char *)NULL;
+  offsets = (size_t *)NULL;
+  blen = bsize = 0;
+  n = nsize = 0;
+
+  errno = 0;
+  while (dp = readdir (d))
+    {
+      if (REAL_DIR_ENTRY (dp) == 0)
+	continue;
+      nlen = D_NAMLEN (dp);
+      if (blen + nlen + 1 > bsize)
+	{
+	  while (blen + nlen + 1 > bsize)
+	    bsize = bsize ? bsize * 2 : 4096;
+	  buf = (char *)xrealloc (buf, bsize);
+	}
+      if (n >= nsize)
+	{
+	  nsize = nsize ? nsize * 2 : 256;
+	  offsets = (size_t *)xrealloc (offsets, nsize * sizeof (size_t));
+	}
+      offsets[n++] = blen;
+      memcpy (buf + blen, dp->d_name, nlen);
+      buf[blen + nlen] = '\0';
+      blen += nlen + 1;
+      errno = 0;
+    }
+
+  if (errno)
+    {
+      closedir (d);
+      FREE (buf);
+      FREE (offsets);
+      return -1;
+    }
+  closedir (d);
+
+  pd->names = strvec_create (n + 1);
+  for (i = 0; i < n; i++)
+    pd->names[i] = buf + offsets[i];
+  pd->names[n] = (char *)NULL;
+  FREE (offsets);
+  if (n > 1)
+    qsort (pd->names, n, sizeof (char *), path_dir_compare);
+
+  pd->namebuf = buf;
+  pd->nnames = n;
+  pd->casefold = path_dir_casefold (pd, dir);
+  pd->dev = sbp->st_dev;
+  pd->ino = sbp->st_ino;
+  pd->mtime = get_stat_mtime (sbp);
+  pd->ctime = get_stat_ctime (sbp);
+  pd->scanned = now;
+
+  return 0;
+}
+
+/* Return non-zero if directory DIR, whose names have been read into PD,
+   looks names up without regard to case, like vfat, WSL's drvfs, or an
+   ext4 casefold directory.  Such a directory finds files under names its
+   listing doesn't contain.  Check by looking up the first name whose
+   ASCII letters can be swapped to a case not already in the listing. */
+static int
+path_dir_casefold (PATH_DIR *pd, const char *dir)
+{
+  char *name, *path, *p;
+  int i, changed, r;
+  struct stat sb;
+
+  for (i = 0; i < pd->nnames; i++)
+    {
+      name = savestring (pd->names[i]);
+      for (changed = 0, p = name; *p; p++)
+	if (*p >= 'a' && *p <= 'z')
+	  {
+	    *p += 'A' - 'a';
+	    changed = 1;
+	  }
+	else if (*p >= 'A' && *p <= 'Z')
+	  {
+	    *p += 'a' - 'A';
+	    changed = 1;
+	  }
+      if (changed == 0 || bsearch (&name, pd->names, pd->nnames, sizeof (char *), path_dir_compare))
+	{
+	  free (name);
+	  continue;
+	}
+      path = sh_makepath (dir, name, 0);
+      r = lstat (path, &sb) == 0;
+      free (path);
+      free (name);
+      return r;
+    }
+  return 0;
+}
+
+/* Return a valid snapshot of directory DIR, reading it if necessary.  Unless
+   SCAN is non-zero, a directory is read only once it has been looked up
+   PATH_INDEX_MINPROBES times.  Returns NULL if there is no usable snapshot. */
+static PATH_DIR *
+path_dir_lookup (const char *dir, int scan)
+{
+  BUCKET_CONTENTS *item;
+  PATH_DIR *pd;
+  struct stat sb;
+  struct timespec mtime, ctime;
+
+  if (path_index_enabled == 0 || dir == 0 || *dir == 0)
+    return ((PATH_DIR *)NULL);
+
+  if (stat (dir, &sb) < 0 || S_ISDIR (sb.st_mode) == 0)
+    return ((PATH_DIR *)NULL);
+
+  if (path_dirs == 0)
+    path_dirs = hash_create (PATH_DIRS_BUCKETS);
+
+  item = hash_search (dir, path_dirs, 0);
+  if (item == 0)
+    {
+      item = hash_insert (savestring (dir), path_dirs, HASH_NOSRCH);
+      pd = (PATH_DIR *)xmalloc (sizeof (PATH_DIR));
+      memset (pd, 0, sizeof (PATH_DIR));
+      item->data = (PTR_T)pd;
+    }
+  else
+    pd = (PATH_DIR *)item->data;
+
+  if (pd->scanned)
+    {
+      mtime = get_stat_mtime (&sb);
+      ctime = get_stat_ctime (&sb);
+      if (pd->dev == sb.st_dev && pd->ino == sb.st_ino &&
+	  timespec_cmp (pd->mtime, mtime) == 0 &&
+	  timespec_cmp (pd->ctime, ctime) == 0 &&
+	  ctime.tv_sec + 1 < pd->scanned)
+	return pd;
+      pd->scanned = 0;
+      pd->probes = 0;
+      if (pd->stale < PATH_INDEX_MAXBACKOFF)
+	pd->stale++;
+    }
+
+  if (scan == 0 && ++pd->probes < (PATH_INDEX_MINPROBES << pd->stale))
+    return ((PATH_DIR *)NULL);
+  pd->probes = 0;
+
+  return ((path_dir_scan (pd, dir, &sb) == 0) ? pd : (PATH_DIR *)NULL);
+}
+
+/* Return 1 if NAME is an entry in directory DIR, 0 if it is not, and -1 if
+   the index can't tell without looking at the file itself. */
+int
+path_dir_has_file (const char *dir, const char *name)
+{
+  PATH_DIR *pd;
+
+  pd = path_dir_lookup (dir, 0);
+  if (pd == 0 || pd->casefold)
+    return -1;
+
+  return (bsearch (&name, pd->names, pd->nnames, sizeof (char *), path_dir_compare) != 0);
+}
+
+/* Return 1 if some entry in directory DIR begins with PREFIX, 0 if none
+   does, and -1 if the index can't tell.  If FOLD is non-zero, compare
+   ignoring case and treating `-' and `_' as equivalent, the way readline's
+   completion-ignore-case and completion-map-case do. */
+int
+path_dir_has_prefix (const char *dir, const char *prefix, int fold)
+{
+  PATH_DIR *pd;
+  const char *p;
+  size_t plen;
+  int lo, hi, mid, i, c1, c2, j;
+
+  if (prefix == 0 || *prefix == 0)
+    return -1;
+  plen = strlen (prefix);
+
+  /* Folding multibyte characters is readline's business. */
+  if (fold)
+    for (p = prefix; *p; p++)
+      if ((unsigned char)*p > 0x7f)
+	return -1;
+
+  pd = path_dir_lookup (dir, 1);
+  if (pd == 0)
+    return -1;
+
+  if (fold == 0)
+    {
+      /* Find the first name not less than PREFIX. */
+      lo = 0;
+      hi = pd->nnames;
+      while (lo < hi)
+	{
+	  mid = lo + (hi - lo) / 2;
+	  if (strcmp (pd->names[mid], prefix) < 0)
+	    lo = mid + 1;
+	  else
+	    hi = mid;
+	}
+      return (lo < pd->nnames && strncmp (pd->names[lo], prefix, plen) == 0);
+    }
+
+  for (i = 0; i < pd->nnames; i++)
+    {
+      for (j = 0; j < plen; j++)
+	{
+	  c1 = (unsigned char)pd->names[i][j];
+	  c2 = (unsigned char)prefix[j];
+	  if (c1 == 0)
+	    break;
+	  c1 = (c1 == '_') ? '-' : TOLOWER (c1);
+	  c2 = (c2 == '_') ? '-' : TOLOWER (c2);
+	  if (c1 != c2)
+	    break;
+	}
+      if (j == plen)
+	return 1;
+    }
+  return 0;
+}
+
+/* Discard every directory snapshot; `hash -r' calls this. */
+void
+path_dir_flush (void)
+{
+  if (path_dirs)
+    hash_flush (path_dirs, path_dir_free);
+}
@@ -40,9 +40,23 @@ extern char *search_for_command (const char *, int);
 extern char *user_command_matches (const char *, int, int);
 extern void setup_exec_ignore (const char *);
 
+extern int path_dir_has_file (const char *, const char *);
+extern int path_dir_has_prefix (const char *, const char *, int);
+extern void path_dir_flush (void);
+
 extern int dot_found_in_search;
 
 /* variables managed via shopt */
 extern int check_hashed_filenames;
+extern int path_index_enabled;
+
+/* Systems whose filesystems fold case or rewrite names (.exe suffixes) can
+   find a file that does not appear in a directory listing under the name
+   looked up, so the PATH directory index can't be trusted there. */
+#if defined (__CYGWIN__) || defined (MACOSX) || defined (__WIN32__) || defined (__MSDOS__)
+#  define PATH_INDEX_DEFAULT	0
+#else
+#  define PATH_INDEX_DEFAULT	1
+#endif
 
 #endif /* _FINDCMD_H_ */
@@ -234,6 +234,8 @@ typedef void sh_unload_func_t (char *);
 
 typedef int sh_builtin_func_t (WORD_LIST *); /* sh_wlist_func_t */
 
+typedef const char *sh_strvec_key_func_t (void *);	/* strvec_keysort */
+
 #endif /* SH_FUNCTION_TYPEDEF */
 
 #define NOW	getnow()
@@ -77,8 +77,7 @@ phash_remove (const char *filename)
     {
       if (item->data)
 	phash_freedata (item->data);
-      free (item->key);
-      free (item);
+      hash_dispose_item (item);
       return 0;
     }
   return 1;
@@ -50,6 +50,22 @@
    don't discard the upper 32 bits of the value, if present. */
 #define HASH_BUCKET(s, t, h) (((h) = hash_string (s)) & ((t)->nbuckets - 1))
 
+/* Number of buckets allocated at a time from the bucket pool. */
+#define BUCKET_POOL_CHUNK	128
+
+/* Hash table entries come from a pool instead of being allocated one at a
+   time, since variables, aliases, and associative array elements create
+   and remove them constantly. */
+sh_obj_pool_t bucket_pool = OPOOL_INITIALIZER (BUCKET_POOL_CHUNK);
+
+/* Calls to hash_search and the chain entries they examined; the ratio is
+   the average probe length.  Reported through $BASH_STATS. */
+unsigned long hash_nsearches;
+unsigned long hash_nprobes;
+
+#define balloc(b)	opool_alloc (bucket_pool, BUCKET_CONTENTS, b)
+#define bfree(b)	opool_free (bucket_pool, BUCKET_CONTENTS, b)
+
 static BUCKET_CONTENTS *copy_bucket_array (BUCKET_CONTENTS *, sh_copy_func_t *);
 
 static void hash_rehash (HASH_TABLE *, int);
@@ -72,6 +88,7 @@ hash_create (int buckets)
     (BUCKET_CONTENTS **)xmalloc (buckets * sizeof (BUCKET_CONTENTS *));
   new_table->nbuckets = buckets;
   new_table->nentries = 0;
+  new_table->refs = (int *)NULL;
 
   for (i = 0; i < buckets; i++)
     new_table->bucket_array[i] = (BUCKET_CONTENTS *)NULL;
@@ -99,12 +116,12 @@ copy_bucket_array (BUCKET_CONTENTS *ba, sh_copy_func_t *cpdata)
     {
       if (n == 0)
         {
-          new_bucket = (BUCKET_CONTENTS *)xmalloc (sizeof (BUCKET_CONTENTS));
+          balloc (new_bucket);
           n = new_bucket;
         }
       else
         {
-          n->next = (BUCKET_CONTENTS *)xmalloc (sizeof (BUCKET_CONTENTS));
+          balloc (n->next);
           n = n->next;
         }
 
@@ -246,8 +263,10 @@ hash_search (const char *string, HASH_TABLE *table, int flags)
 
   bucket = HASH_BUCKET (string, table, hv);
 
+  hash_nsearches++;
   for (list = table->bucket_array ? table->bucket_array[bucket] : 0; list; list = list->next)
     {
+      hash_nprobes++;
       /* This is the comparison function */
       if (hv == list->khash && STREQ (list->key, string))
 	{
@@ -264,7 +283,7 @@ hash_search (const char *string, HASH_TABLE *table, int flags)
 	  bucket = HASH_BUCKET (string, table, hv);
 	}
 
-      list = (BUCKET_CONTENTS *)xmalloc (sizeof (BUCKET_CONTENTS));
+      balloc (list);
       list->next = table->bucket_array[bucket];
       table->bucket_array[bucket] = list;
 
@@ -312,6 +331,15 @@ hash_remove (const char *string, HASH_TABLE *table, int flags)
   return ((BUCKET_CONTENTS *) NULL);
 }
 
+/* Free ITEM, an entry returned by hash_remove, and its key.  The caller
+   is responsible for disposing of the data. */
+void
+hash_dispose_item (BUCKET_CONTENTS *item)
+{
+  free (item->key);
+  bfree (item);
+}
+
 /* Create an entry for STRING, in TABLE.  If the entry already
    exists, then return it (unless the HASH_NOSRCH flag is set). */
 BUCKET_CONTENTS *
@@ -334,7 +362,7 @@ hash_insert (char *string, HASH_TABLE *table, int flags)
 
       bucket = HASH_BUCKET (string, table, hv);
 
-      item = (BUCKET_CONTENTS *)xmalloc (sizeof (BUCKET_CONTENTS));
+      balloc (item);
       item->next = table->bucket_array[bucket];
       table->bucket_array[bucket] = item;
 
@@ -375,7 +403,7 @@ hash_flush (HASH_TABLE *table, sh_free_func_t *free_data)
 	  else
 	    free (item->data);
 	  free (item->key);
-	  free (item);
+	  bfree (item);
 	}
       table->bucket_array[i] = (BUCKET_CONTENTS *)NULL;
     }
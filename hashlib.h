@@ -39,6 +39,7 @@ typedef struct hash_table {
   BUCKET_CONTENTS **bucket_array;	/* Where the data is kept. */
   int nbuckets;			/* How many buckets does this table have. */
   int nentries;			/* How many entries does this table have. */
+  int *refs;			/* Tables sharing BUCKET_ARRAY, or NULL. */
 } HASH_TABLE;
 
 typedef int hash_wfunc (BUCKET_CONTENTS *);
@@ -58,6 +59,9 @@ extern int hash_size (HASH_TABLE *);
 extern BUCKET_CONTENTS *hash_search (const char *, HASH_TABLE *, int);
 extern BUCKET_CONTENTS *hash_insert (char *, HASH_TABLE *, int);
 extern BUCKET_CONTENTS *hash_remove (const char *, HASH_TABLE *, int);
+extern void hash_dispose_item (BUCKET_CONTENTS *);
+
+extern unsigned long hash_nsearches, hash_nprobes;
 
 /* Miscellaneous */
 extern unsigned int hash_string (const char *);
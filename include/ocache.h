@@ -124,4 +124,78 @@ typedef struct objcache {
  * The use is almost arbitrary.
  */
 
+/*
+ * Object pools.  A pool hands out fixed-size objects carved from chunks of
+ * NPER contiguous objects allocated with xmalloc, and keeps freed objects
+ * on a free list threaded through the objects themselves.  Unlike an
+ * object cache, a pool never returns memory: chunks live as long as the
+ * shell does, so objects allocated from a pool must only be freed with
+ * opool_free on the same pool, never with xfree.  OTYPE must be at least
+ * as large as a pointer.
+ */
+typedef struct objpool {
+	PTR_T	freelist;	/* free objects, linked through their first word */
+	int	nper;		/* objects per chunk */
+	unsigned long	nchunks;	/* number of chunks allocated */
+	unsigned long	nalloc;		/* number of objects handed out */
+	unsigned long	nfree;		/* number of objects returned */
+	unsigned long	ninuse;		/* objects currently allocated */
+	unsigned long	maxinuse;	/* high-water mark of ninuse */
+} sh_obj_pool_t;
+
+/* Initializer for a pool that allocates N objects at a time. */
+#define OPOOL_INITIALIZER(n)	{ 0, (n), 0, 0, 0, 0, 0 }
+
+/* Allocate a new chunk of objects of type OTYPE and add them to the free
+   list of pool P, in address order. */
+#define opool_grow(p, otype) \
+	do { \
+		register char *oc_chunk; \
+		register int oc_i; \
+		oc_chunk = (char *)xmalloc ((p).nper * sizeof (otype)); \
+		for (oc_i = (p).nper - 1; oc_i >= 0; oc_i--) { \
+			*(PTR_T *)(oc_chunk + oc_i * sizeof (otype)) = (p).freelist; \
+			(p).freelist = (PTR_T)(oc_chunk + oc_i * sizeof (otype)); \
+		} \
+		(p).nchunks++; \
+	} while (0)
+
+/*
+ * Allocate a new item of type pointer to OTYPE from pool P, allocating a
+ * new chunk if the free list is empty.  Return the object in R.
+ */
+#define opool_alloc(p, otype, r) \
+	do { \
+		if ((p).freelist == 0) \
+			opool_grow (p, otype); \
+		(r) = (otype *)(p).freelist; \
+		(p).freelist = *(PTR_T *)(r); \
+		(p).nalloc++; \
+		if (++(p).ninuse > (p).maxinuse) \
+			(p).maxinuse = (p).ninuse; \
+	} while (0)
+
+/*
+ * Return an item R of type pointer to OTYPE to pool P.  The contents are
+ * scrambled before R is added to the free list.
+ */
+#define opool_free(p, otype, r) \
+	do { \
+		OC_MEMSET ((r), 0xdf, sizeof(otype)); \
+		*(PTR_T *)(r) = (p).freelist; \
+		(p).freelist = (PTR_T)(r); \
+		(p).nfree++; \
+		(p).ninuse--; \
+	} while (0)
+
+/*
+ * A pool is declared and used as (for instance):
+ *
+ *	sh_obj_pool_t varpool = OPOOL_INITIALIZER (64);
+ *
+ *	SHELL_VAR *v;
+ *	opool_alloc (varpool, SHELL_VAR, v);
+ *	opool_free (varpool, SHELL_VAR, v);
+ */
+
 #endif /* _OCACHE_H  */
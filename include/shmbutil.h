@@ -34,11 +34,13 @@ extern size_t xmbsrtowcs (wchar_t *, const char **, size_t, mbstate_t *);
 extern size_t xdupmbstowcs (wchar_t **, char ***, const char *);
 
 extern size_t mbstrlen (const char *);
+extern size_t mbsasciispan (const char *);
 
 extern char *xstrchr (const char *, int);
 
 extern int locale_mb_cur_max;	/* XXX */
 extern int locale_utf8locale;	/* XXX */
+extern int locale_shiftstates;	/* XXX */
 
 #ifndef MB_INVALIDCH
 #define MB_INVALIDCH(x)		((x) == (size_t)-1 || (x) == (size_t)-2)
@@ -70,6 +70,7 @@
 #include "jobs.h"
 #include "execute_cmd.h"
 #include "flags.h"
+#include "profile.h"
 
 #include "typemax.h"
 
@@ -2301,6 +2302,8 @@ make_child (char *command, int flags)
   if (default_buffered_input != -1 && (!async_p || default_buffered_input > 0))
     sync_buffered_stream (default_buffered_input);
 
+  xtrace_flush ();
+
   /* Create the child, handle severe errors.  Retry on EAGAIN. */
   while ((pid = fork ()) < 0 && errno == EAGAIN && forksleep < FORKSLEEP_MAX)
     {
@@ -2312,6 +2315,7 @@ make_child (char *command, int flags)
 
       errno = EAGAIN;		/* restore errno */
       sys_error ("fork: retry");
+      shell_stats.fork_retries++;
 
       if (sleep (forksleep) != 0)
 	break;
@@ -2329,6 +2333,7 @@ make_child (char *command, int flags)
   if (pid < 0)
     {
       sys_error ("fork");
+      shell_stats.fork_failures++;
 
       /* Kill all of the processes in the current pipeline. */
       terminate_current_pipeline ();
@@ -2361,6 +2366,9 @@ make_child (char *command, int flags)
 
       CLRINTERRUPT;	/* XXX - children have their own interrupt state */
 
+      /* Only the process that started the profiler reports. */
+      profiling_enabled = 0;
+
       /* Restore top-level signal mask, including unblocking SIGTERM */
       restore_sigmask ();
   
@@ -2438,6 +2446,8 @@ make_child (char *command, int flags)
       /* In the parent.  Remember the pid of the child just created
 	 as the proper pgrp if this is the first child. */
 
+      shell_stats.forks++;
+
       if (job_control)
 	{
 	  if (pipeline_pgrp == 0)
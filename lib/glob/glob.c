@@ -100,6 +100,9 @@ int glob_always_skip_dot_and_dotdot = 1;
 /* Global variable to return to signify an error in globbing. */
 char *glob_error_return;
 
+/* Directory entries read by glob_vector. */
+unsigned long glob_ndirents;
+
 static struct globval finddirs_error_return;
 
 /* Some forward declarations. */
@@ -803,6 +806,7 @@ glob_vector (char *pat, char *dir, int flags)
 	  dp = readdir (d);
 	  if (dp == NULL)
 	    break;
+	  glob_ndirents++;
 
 	  /* If this directory entry is not to be used, try again. */
 	  if (REAL_DIR_ENTRY (dp) == 0)
@@ -43,5 +43,6 @@ extern int extglob_pattern_p (const char *);
 extern char *glob_error_return;
 extern int noglob_dot_filenames;
 extern int glob_ignore_case;
+extern unsigned long glob_ndirents;
 
 #endif /* _GLOB_H_ */
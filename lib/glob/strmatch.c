@@ -29,9 +29,13 @@ extern int xstrmatch (char *, char *, int);
 extern int internal_wstrmatch (wchar_t *, wchar_t *, int);
 #endif
 
+/* Calls to strmatch and wcsmatch. */
+unsigned long strmatch_ncalls;
+
 int
 strmatch (char *pattern, char *string, int flags)
 {
+  strmatch_ncalls++;
   if (string == 0 || pattern == 0)
     return FNM_NOMATCH;
 
@@ -42,6 +46,7 @@ strmatch (char *pattern, char *string, int flags)
 int
 wcsmatch (wchar_t *wpattern, wchar_t *wstring, int flags)
 {
+  strmatch_ncalls++;
   if (wstring == 0 || wpattern == 0)
     return (FNM_NOMATCH);
 
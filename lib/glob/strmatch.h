@@ -58,6 +58,8 @@
    returning zero if it matches, FNM_NOMATCH if not.  */
 extern int strmatch (char *, char *, int);
 
+extern unsigned long strmatch_ncalls;
+
 #if HANDLE_MULTIBYTE
 extern int wcsmatch (wchar_t *, wchar_t *, int);
 #endif
@@ -777,14 +777,7 @@ _rl_untranslate_macro_value (char *seq, int use_escapes)
 rl_command_func_t *
 rl_named_function (const char *string)
 {
-  register int i;
-
-  rl_initialize_funmap ();
-
-  for (i = 0; funmap[i]; i++)
-    if (_rl_stricmp (funmap[i]->name, string) == 0)
-      return (funmap[i]->function);
-  return ((rl_command_func_t *)NULL);
+  return (_rl_funmap_lookup (string));
 }
 
 /* Return the function (or macro) definition which would be invoked via
@@ -1887,6 +1880,7 @@ static const struct {
   { "enable-bracketed-paste",	&_rl_enable_bracketed_paste,	V_SPECIAL },
   { "enable-keypad",		&_rl_enable_keypad,		0 },
   { "enable-meta-key",		&_rl_enable_meta,		0 },
+  { "enable-synchronized-output", &_rl_enable_synchronized_output, 0 },
   { "expand-tilde",		&rl_complete_with_tilde_expansion, 0 },
   { "force-meta-prefix",	&_rl_force_meta_prefix,		0 },
   { "history-preserve-point",	&_rl_history_preserve_point,	0 },
@@ -1900,6 +1894,7 @@ static const struct {
   { "meta-flag",		&_rl_meta_flag,			0 },
   { "output-meta",		&_rl_output_meta_chars,		0 },
   { "page-completions",		&_rl_page_completions,		0 },
+  { "page-completions-incrementally", &_rl_page_completions_incrementally, 0 },
   { "prefer-visible-bell",	&_rl_prefer_visible_bell,	V_SPECIAL },
   { "print-completions-horizontally", &_rl_print_completions_horizontally, 0 },
   { "revert-all-at-newline",	&_rl_revert_all_at_newline,	0 },
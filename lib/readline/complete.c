@@ -140,7 +140,10 @@ static int print_filename (char *, char *, int);
 
 static char **gen_completion_matches (char *, int, int, rl_compentry_func_t *, int, int);
 
+static unsigned int match_hash (const char *);
 static char **remove_duplicate_matches (char **);
+static void sort_pending_matches (char **, int);
+static size_t common_prefix_bytes (const char *, const char *, size_t);
 static void insert_match (char *, int, int, char *);
 static int append_to_match (char *, int, int, int);
 static void insert_all_matches (char **, int, char *);
@@ -150,6 +153,7 @@ static int compute_lcd_of_matches (char **, int, const char *);
 static int postprocess_matches (char ***, int);
 static int compare_match (char *, const char *);
 static int complete_get_screenwidth (void);
+static void display_match_pages (char **, int, int, int);
 
 static char *make_quoted_replacement (char *, int, char *);
 
@@ -308,6 +312,14 @@ int rl_completion_query_items = 100;
 
 int _rl_page_completions = 1;
 
+/* Non-zero means that when the pager is used, the list of possible
+   completions is laid out, sorted, and printed a page at a time, so the
+   first page doesn't wait for all of the matches to be measured. */
+int _rl_page_completions_incrementally = 0;
+
+#define INCREMENTAL_PAGING() \
+  (_rl_page_completions && _rl_page_completions_incrementally && _rl_screenheight > 1)
+
 /* The basic list of characters that signal a break between words for the
    completer routine.  The contents of this variable is what breaks words
    in the shell, i.e. " \t\n\"\\'`@$><=" */
@@ -438,6 +450,11 @@ int rl_sort_completion_matches = 1;
 
 /* Local variable states what happened during the last completion attempt. */
 static int completion_changed_buffer;
+
+/* The match list postprocess_matches left unsorted, if any, and how many of
+   its entries (counting from matches[1]) have been sorted since. */
+static char **unsorted_matches;
+static int unsorted_from;
 static int last_completion_failed = 0;
 
 /* The result of the query to the user about displaying completion matches */
@@ -1308,50 +1325,75 @@ gen_completion_matches (char *text, int start, int end, rl_compentry_func_t *our
   return matches;  
 }
 
+/* Hash the string S for remove_duplicate_matches (). */
+static unsigned int
+match_hash (const char *s)
+{
+  unsigned int h;
+
+  for (h = 2166136261U; *s; s++)
+    h = (h ^ (unsigned char)*s) * 16777619U;
+  return h;
+}
+
 /* Filter out duplicates in MATCHES.  This frees up the strings in
-   MATCHES. */
+   MATCHES.  Duplicates are found with a hash table, so this takes time
+   linear in the number of matches and keeps them in the order they were
+   generated; sorting them is left until something needs them in order
+   (see sort_pending_matches). */
 static char **
 remove_duplicate_matches (char **matches)
 {
   char *lowest_common;
-  int i, j, newlen;
-  char dead_slot;
+  int i, j, n, *table;
+  size_t tsize, mask, h;
   char **temp_array;
 
-  /* Sort the items. */
-  i = vector_len (matches);
-
-  /* Sort the array without matches[0], since we need it to
-     stay in place no matter what. */
-  if (i && rl_sort_completion_matches)
-    qsort (matches+1, i-1, sizeof (char *), (QSFUNC *)_rl_qsort_string_compare);
+  n = vector_len (matches);
 
   /* Remember the lowest common denominator for it may be unique. */
   lowest_common = savestring (matches[0]);
 
-  for (i = newlen = 0; matches[i + 1]; i++)
+  table = (int *)NULL;
+  mask = 0;
+  if (rl_sort_completion_matches)
     {
-      if (strcmp (matches[i], matches[i + 1]) == 0)
-	{
-	  xfree (matches[i]);
-	  matches[i] = (char *)&dead_slot;
-	}
-      else
-	newlen++;
+      for (tsize = 16; tsize < (size_t)n * 2; tsize <<= 1)
+	;
+      mask = tsize - 1;
+      table = (int *)xmalloc (tsize * sizeof (int));
+      memset (table, 0, tsize * sizeof (int));
     }
 
-  /* We have marked all the dead slots with (char *)&dead_slot.
-     Copy all the non-dead entries into a new array. */
-  temp_array = (char **)xmalloc ((3 + newlen) * sizeof (char *));
+  /* TABLE holds indices into TEMP_ARRAY of the matches kept so far; 0 marks
+     an empty slot.  If the matches aren't going to be sorted, only
+     adjacent duplicates are removed, as they always have been. */
+  temp_array = (char **)xmalloc ((n + 2) * sizeof (char *));
   for (i = j = 1; matches[i]; i++)
     {
-      if (matches[i] != (char *)&dead_slot)
-	temp_array[j++] = matches[i];
+      if (rl_sort_completion_matches == 0)
+	{
+	  if (j > 1 && strcmp (temp_array[j - 1], matches[i]) == 0)
+	    xfree (matches[i]);
+	  else
+	    temp_array[j++] = matches[i];
+	  continue;
+	}
+      for (h = match_hash (matches[i]) & mask; table[h]; h = (h + 1) & mask)
+	if (strcmp (temp_array[table[h]], matches[i]) == 0)
+	  break;
+      if (table[h])
+	xfree (matches[i]);
+      else
+	{
+	  table[h] = j;
+	  temp_array[j++] = matches[i];
+	}
     }
   temp_array[j] = (char *)NULL;
+  xfree (table);
 
-  if (matches[0] != (char *)&dead_slot)
-    xfree (matches[0]);
+  xfree (matches[0]);
 
   /* Place the lowest common denominator back in [0]. */
   temp_array[0] = lowest_common;
@@ -1367,6 +1409,51 @@ remove_duplicate_matches (char **matches)
   return (temp_array);
 }
 
+/* Sort MATCHES if postprocess_matches left them unsorted.  K is the number
+   of matches, counting from matches[1], the caller needs in order; 0 means
+   all of them. */
+static void
+sort_pending_matches (char **matches, int k)
+{
+  int len;
+
+  if (matches == 0 || matches != unsorted_matches)
+    return;
+
+  len = vector_len (matches + 1);
+  if (k > 0 && k < len - unsorted_from)
+    {
+      _rl_sort_strings_prefix (matches + 1 + unsorted_from, len - unsorted_from, k);
+      unsorted_from += k;
+    }
+  else
+    {
+      _rl_sort_strings (matches + 1 + unsorted_from, len - unsorted_from);
+      unsorted_matches = (char **)NULL;
+      unsorted_from = 0;
+    }
+}
+
+/* Return the number of leading bytes S1 and S2 have in common, looking at
+   no more than MAX bytes of each.  Compares a word at a time. */
+static size_t
+common_prefix_bytes (const char *s1, const char *s2, size_t max)
+{
+  size_t i;
+  unsigned long w1, w2;
+
+  for (i = 0; i + sizeof (unsigned long) <= max; i += sizeof (unsigned long))
+    {
+      memcpy (&w1, s1 + i, sizeof (unsigned long));
+      memcpy (&w2, s2 + i, sizeof (unsigned long));
+      if (w1 != w2)
+	break;
+    }
+  while (i < max && s1[i] == s2[i])
+    i++;
+  return i;
+}
+
 /* Find the common prefix of the list of matches, and put it into
    matches[0]. */
 static int
@@ -1374,10 +1461,10 @@ compute_lcd_of_matches (char **match_list, int matches, const char *text)
 {
   register int i, c1, c2, si;
   int low;		/* Count of max-matched characters. */
-  int lx;
+  int lx, best, mbcheck;
   char *dtext;		/* dequoted TEXT, if needed */
   size_t si1, si2;
-  size_t len1, len2;
+  size_t len1, len2, blen;
 #if defined (HANDLE_MULTIBYTE)
   size_t v1, v2;
   mbstate_t ps1, ps2;
@@ -1394,20 +1481,49 @@ compute_lcd_of_matches (char **match_list, int matches, const char *text)
       return 1;
     }
 
+#if defined (HANDLE_MULTIBYTE)
+  mbcheck = MB_CUR_MAX > 1 && rl_byte_oriented == 0;
+#else
+  mbcheck = 0;
+#endif
+
+  len2 = strlen (match_list[1]);
   for (i = 1, low = 100000; i < matches; i++)
     {
+      len1 = len2;
+      len2 = strlen (match_list[i + 1]);
+
+      /* Without case folding, the matches can't agree past the bytes they
+	 have in common, which we can find a word at a time.  In a multibyte
+	 locale, a pair whose bytes agree well past LOW (so no character
+	 straddles it) can't lower it, and identical matches agree all the
+	 way; otherwise compare them character by character below. */
+      if (_rl_completion_case_fold == 0)
+	{
+	  blen = common_prefix_bytes (match_list[i], match_list[i + 1], MIN (len1, len2));
+	  if (mbcheck == 0 || (blen == len1 && len1 == len2))
+	    {
+	      if (low > blen)
+		low = blen;
+	      continue;
+	    }
+	  if (blen >= (size_t)low + MB_CUR_MAX)
+	    continue;
+	}
+
 #if defined (HANDLE_MULTIBYTE)
-      if (MB_CUR_MAX > 1 && rl_byte_oriented == 0)
+      if (mbcheck)
 	{
 	  memset (&ps1, 0, sizeof (mbstate_t));
 	  memset (&ps2, 0, sizeof (mbstate_t));
 	}
 #endif
-      len1 = strlen (match_list[i]);
-      len2 = strlen (match_list[i + 1]);
 
       for (si1 = si2 = 0; (c1 = match_list[i][si1]) && (c2 = match_list[i + 1][si2]); si1++,si2++)
 	{
+	    /* Past LOW, this pair can't make the common prefix any shorter. */
+	    if (si1 >= low && si2 >= low)
+	      break;
 	    if (_rl_completion_case_fold)
 	      {
 	        c1 = _rl_to_lower (c1);
@@ -1484,25 +1600,35 @@ compute_lcd_of_matches (char **match_list, int matches, const char *text)
 	      text = dtext;
 	    }
 
-	  /* sort the list to get consistent answers. */
-	  if (rl_sort_completion_matches)
-	    qsort (match_list+1, matches, sizeof(char *), (QSFUNC *)_rl_qsort_string_compare);
-
 	  si = strlen (text);
 	  lx = (si <= low) ? si : low;	/* check shorter of text and matches */
 	  /* Try to preserve the case of what the user typed in the presence of
 	     multiple matches: check each match for something that matches
 	     what the user typed taking case into account; use it up to common
-	     length of matches if one is found.  If not, just use first match. */
+	     length of matches if one is found.  If not, just use first match.
+	     If we're sorting matches, `first' means first in sorted order, so
+	     we get consistent answers; find it without sorting the list. */
+	  best = 0;
 	  for (i = 1; i <= matches; i++)
 	    if (strncmp (match_list[i], text, lx) == 0)
 	      {
-		strncpy (match_list[0], match_list[i], low);
-		break;
+		if (best == 0)
+		  best = i;
+		else if (rl_sort_completion_matches == 0)
+		  break;
+		else if (_rl_qsort_string_compare (&match_list[i], &match_list[best]) < 0)
+		  best = i;
 	      }
 	  /* no casematch, use first entry */
-	  if (i > matches)
-	    strncpy (match_list[0], match_list[1], low);
+	  if (best == 0)
+	    {
+	      best = 1;
+	      if (rl_sort_completion_matches)
+		for (i = 2; i <= matches; i++)
+		  if (_rl_qsort_string_compare (&match_list[i], &match_list[best]) < 0)
+		    best = i;
+	    }
+	  strncpy (match_list[0], match_list[best], low);
 
 	  FREE (dtext);
 	}
@@ -1529,11 +1655,15 @@ postprocess_matches (char ***matchesp, int matching_filenames)
   /* It seems to me that in all the cases we handle we would like
      to ignore duplicate possibilities.  Scan for the text to
      insert being identical to the other completions. */
+  unsorted_matches = (char **)NULL;
+  unsorted_from = 0;
   if (rl_ignore_completion_duplicates)
     {
       temp_matches = remove_duplicate_matches (matches);
       xfree (matches);
       matches = temp_matches;
+      if (rl_sort_completion_matches)
+	unsorted_matches = matches;
     }
 
   /* If we are matching filenames, then here is our chance to
@@ -1548,6 +1678,7 @@ postprocess_matches (char ***matchesp, int matching_filenames)
       if (matches == 0 || matches[0] == 0)
 	{
 	  FREE (matches);
+	  unsorted_matches = (char **)NULL;
 	  *matchesp = (char **)0;
 	  return 0;
         }
@@ -1586,6 +1717,98 @@ complete_get_screenwidth (void)
   return _rl_screenwidth;
 }
 
+/* Display the LEN MATCHES a page at a time.  Each page is laid out on its
+   own, using the widest of the matches that could fit on it, and only the
+   matches that end up on a page are sorted (if they haven't been already)
+   and printed, so the time it takes to show a page doesn't depend on the
+   length of the list.  SIND and SHRINK are the index of the end of the
+   common prefix and the width it saves, from rl_display_match_list. */
+static void
+display_match_pages (char **matches, int len, int sind, int shrink)
+{
+  int cols, lines, first, avail, k, n, max, limit, count;
+  int i, j, l, w, printed_len;
+  char *temp;
+
+  cols = complete_get_screenwidth ();
+
+  rl_crlf ();
+
+  lines = 0;
+  for (first = 1; first <= len; first += n)
+    {
+      /* The pager leaves either a full page or a single line to fill. */
+      avail = _rl_screenheight - 1 - lines;
+      if (avail < 1)
+	avail = 1;
+
+      /* No more than this many matches can fit, even if they're all one
+	 character wide. */
+      k = avail * ((cols / 3 > 0) ? cols / 3 : 1);
+      if (k > len - first + 1)
+	k = len - first + 1;
+      if (matches == unsorted_matches && first - 1 + k > unsorted_from)
+	sort_pending_matches (matches, first - 1 + k - unsorted_from);
+
+      for (max = 0, i = first; i < first + k; i++)
+	{
+	  w = fnwidth (printable_part (matches[i]));
+	  if (w > max)
+	    max = w;
+	}
+      max -= shrink;
+
+      /* The same layout rl_display_match_list uses, applied to this page. */
+      max += 2;
+      limit = cols / max;
+      if (limit != 1 && (limit * max == cols))
+	limit--;
+      if (limit <= 0)
+	limit = 1;
+
+      n = avail * limit;
+      if (n > k)
+	n = k;
+      count = (n + (limit - 1)) / limit;
+
+      for (i = 0; i < count; i++)
+	{
+	  for (j = 0; j < limit; j++)
+	    {
+	      l = _rl_print_completions_horizontally ? i * limit + j : j * count + i;
+	      if (l >= n)
+		break;
+	      temp = printable_part (matches[first + l]);
+	      printed_len = print_filename (temp, matches[first + l], sind);
+
+	      if (j + 1 < limit)
+		{
+		  if (max <= printed_len)
+		    putc (' ', rl_outstream);
+		  else
+		    for (w = 0; w < max - printed_len; w++)
+		      putc (' ', rl_outstream);
+		}
+	    }
+	  rl_crlf ();
+#if defined (SIGWINCH)
+	  if (RL_SIG_RECEIVED () && RL_SIGWINCH_RECEIVED() == 0)
+#else
+	  if (RL_SIG_RECEIVED ())
+#endif
+	    return;
+	  lines++;
+	}
+
+      if (first + n <= len)
+	{
+	  lines = _rl_internal_pager (lines);
+	  if (lines < 0 || _rl_complete_display_matches_interrupt)
+	    return;
+	}
+    }
+}
+
 /* A convenience function for displaying a list of strings in
    columnar format on readline's output stream.  MATCHES is the list
    of strings, in argv format, LEN is the number of strings in MATCHES,
@@ -1594,12 +1817,12 @@ void
 rl_display_match_list (char **matches, int len, int max)
 {
   int count, limit, printed_len, lines, cols;
-  int i, j, k, l, common_length, sind;
+  int i, j, k, l, common_length, sind, sorted, shrink;
   char *temp, *t;
 
   /* Find the length of the prefix common to all items: length as displayed
      characters (common_length) and as a byte index into the matches (sind) */
-  common_length = sind = 0;
+  common_length = sind = shrink = 0;
   if (_rl_completion_prefix_display_length > 0)
     {
       t = printable_part (matches[0]);
@@ -1611,7 +1834,7 @@ rl_display_match_list (char **matches, int len, int max)
 	common_length = sind = 0;
 
       if (common_length > _rl_completion_prefix_display_length && common_length > ELLIPSIS_LEN)
-	max -= common_length - ELLIPSIS_LEN;
+	max -= shrink = common_length - ELLIPSIS_LEN;
       else if (_rl_colored_completion_prefix <= 0)
 	common_length = sind = 0;
     }
@@ -1652,7 +1875,13 @@ rl_display_match_list (char **matches, int len, int max)
 
   /* Sort the items if they are not already sorted. */
   if (rl_ignore_completion_duplicates == 0 && rl_sort_completion_matches)
-    qsort (matches + 1, len, sizeof (char *), (QSFUNC *)_rl_qsort_string_compare);
+    _rl_sort_strings (matches + 1, len);
+
+  if (INCREMENTAL_PAGING ())
+    {
+      display_match_pages (matches, len, sind, shrink);
+      return;
+    }
 
   rl_crlf ();
 
@@ -1700,9 +1929,20 @@ rl_display_match_list (char **matches, int len, int max)
     }
   else
     {
-      /* Print the sorted items, across alphabetically, like ls -x. */
+      /* Print the sorted items, across alphabetically, like ls -x.  If the
+	 matches haven't been sorted yet, sort a page at a time (or as many
+	 as have been sorted already, whichever is more) as we get to them. */
+      sorted = 0;
       for (i = 1; matches[i]; i++)
 	{
+	  if (i > sorted && matches == unsorted_matches)
+	    {
+	      k = limit * (_rl_screenheight > 1 ? _rl_screenheight - 1 : 1);
+	      if (k < sorted)
+		k = sorted;
+	      sort_pending_matches (matches, k);
+	      sorted += k;
+	    }
 	  temp = printable_part (matches[i]);
 	  printed_len = print_filename (temp, matches[i], sind);
 	  /* Have we reached the end of this line? */
@@ -1750,7 +1990,7 @@ rl_display_match_list (char **matches, int len, int max)
 static void
 display_matches (char **matches)
 {
-  int len, max, i;
+  int len, max, i, j, n;
   char *temp;
 
   /* Move to the last visible line of a possibly-multiple-line command. */
@@ -1771,21 +2011,31 @@ display_matches (char **matches)
     }
 
   /* There is more than one answer.  Find out how many there are,
-     and find the maximum printed length of a single entry. */
-  for (max = 0, i = 1; matches[i]; i++)
+     and find the maximum printed length of a single entry.  If the list
+     is going to be laid out a page at a time, the first page's worth
+     is enough. */
+  len = vector_len (matches + 1);
+  n = len;
+  if (rl_completion_display_matches_hook == 0 && INCREMENTAL_PAGING ())
+    {
+      i = complete_get_screenwidth () / 3;
+      n = (_rl_screenheight - 1) * ((i > 0) ? i : 1);
+      if (n > len)
+	n = len;
+    }
+  for (max = 0, i = 1; i <= n; i++)
     {
       temp = printable_part (matches[i]);
-      len = fnwidth (temp);
+      j = fnwidth (temp);
 
-      if (len > max)
-	max = len;
+      if (j > max)
+	max = j;
     }
 
-  len = i - 1;
-
   /* If the caller has defined a display hook, then call that now. */
   if (rl_completion_display_matches_hook)
     {
+      sort_pending_matches (matches, 0);
       (*rl_completion_display_matches_hook) (matches, len, max);
       return;
     }
@@ -1808,6 +2058,12 @@ display_matches (char **matches)
 	}
     }
 
+  /* Only now that we know they're going to be displayed do the matches
+     need sorting.  When they're printed across or laid out a page at a
+     time, rl_display_match_list sorts only as many as it prints. */
+  if ((_rl_print_completions_horizontally == 0 || _rl_page_completions == 0) && INCREMENTAL_PAGING () == 0)
+    sort_pending_matches (matches, 0);
+
   /* We rely on the caller to set MATCHES to 0 when this returns. */
   if (_rl_complete_display_matches_interrupt == 0)
     rl_display_match_list (matches, len, max);
@@ -2031,6 +2287,9 @@ _rl_free_match_list (char **matches)
   if (matches == 0)
     return;
 
+  if (matches == unsorted_matches)
+    unsorted_matches = (char **)NULL;
+
   for (i = 0; matches[i]; i++)
     xfree (matches[i]);
   xfree (matches);
@@ -2209,6 +2468,7 @@ rl_complete_internal (int what_to_do)
       break;
 
     case '*':
+      sort_pending_matches (matches, 0);
       insert_all_matches (matches, start, &quote_char);
       break;
 
@@ -2229,6 +2489,7 @@ rl_complete_internal (int what_to_do)
       break;
 
     case '$':
+      sort_pending_matches (matches, 0);
       _rl_export_completions (matches, text, start, end);
       xfree (text);
       break;
@@ -2348,8 +2609,13 @@ rl_completion_matches (const char *text, rl_compentry_func_t *entry_function)
 	}
 
       if (matches + 1 >= match_list_size)
-	match_list = (char **)xrealloc
-	  (match_list, ((match_list_size += 10) + 1) * sizeof (char *));
+	{
+	  /* Grow geometrically; completions can number in the hundreds of
+	     thousands. */
+	  match_list_size = match_list_size ? match_list_size * 2 : 10;
+	  match_list = (char **)xrealloc
+	    (match_list, (match_list_size + 1) * sizeof (char *));
+	}
 
       if (match_list == 0)
 	return (match_list);
@@ -2798,6 +3064,9 @@ rl_old_menu_complete (int count, int invoking_key)
 
       RL_UNSETSTATE(RL_STATE_COMPLETING);
 
+      /* Menu completion cycles through the matches in order. */
+      sort_pending_matches (matches, 0);
+
       match_list_size = vector_len (matches);
 
       /* matches[0] is lcd if match_list_size > 1, but the circular buffer
@@ -2933,6 +3202,9 @@ rl_menu_complete (int count, int ignore)
 
       RL_UNSETSTATE(RL_STATE_COMPLETING);
 
+      /* Menu completion cycles through the matches in order. */
+      sort_pending_matches (matches, 0);
+
       match_list_size = vector_len (matches);
 
       if (match_list_size == 0) 
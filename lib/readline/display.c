@@ -831,6 +831,9 @@ rl_redisplay (void)
   _rl_block_sigint ();  
   RL_SETSTATE (RL_STATE_REDISPLAYING);
 
+  /* Collect the output and write it all at once at the end. */
+  _rl_frame_begin ();
+
   cur_face = FACE_NORMAL;
   /* Can turn this into an array for multiple highlighted objects in addition
      to the region */
@@ -1687,6 +1690,7 @@ rl_redisplay (void)
 	  last_lmargin = lmargin;
 	}
     }
+  _rl_frame_end ();
   fflush (rl_outstream);
 
   /* Swap visible and non-visible lines. */
@@ -1730,7 +1734,7 @@ putc_face (int c, int face, char *cur_face)
       *cur_face = face;
     }
   if (c != EOF)
-    putc (c, rl_outstream);
+    _rl_output_character_function (c);
 }
 
 static void
@@ -1952,7 +1956,7 @@ update_line (char *old, char *old_face, char *new, char *new_face, int current_l
 	    }
 	  else
 	    {
-	      putc (' ', rl_outstream);
+	      _rl_output_character_function (' ');
 	      _rl_last_c_pos = 1;
 	      _rl_last_v_pos++;
 	      if (old[0] && new[0])
@@ -1968,7 +1972,7 @@ update_line (char *old, char *old_face, char *new, char *new_face, int current_l
 	  if (new[0])
 	    puts_face (new, new_face, 1);
 	  else
-	    putc (' ', rl_outstream);
+	    _rl_output_character_function (' ');
 	  _rl_last_c_pos = 1;
 	  _rl_last_v_pos++;
 	  if (old[0] && new[0])
@@ -3048,7 +3052,7 @@ _rl_move_vert (int to)
   if ((delta = to - _rl_last_v_pos) > 0)
     {
       for (i = 0; i < delta; i++)
-	putc ('\n', rl_outstream);
+	_rl_output_character_function ('\n');
       _rl_cr ();
       _rl_last_c_pos = 0;
     }
@@ -3057,6 +3061,7 @@ _rl_move_vert (int to)
 #ifdef __DJGPP__
       int row, col;
 
+      _rl_frame_flush ();
       fflush (rl_outstream);
       ScreenGetCursor (&row, &col);
       ScreenSetCursor (row + delta, col);
@@ -3335,7 +3340,7 @@ space_to_eol (int count)
   register int i;
 
   for (i = 0; i < count; i++)
-    putc (' ', rl_outstream);
+    _rl_output_character_function (' ');
 
   _rl_last_c_pos += count;
 }
@@ -3589,8 +3594,10 @@ _rl_current_display_line (void)
 void
 _rl_refresh_line (void)
 {
+  _rl_frame_begin ();
   rl_clear_visible_line ();
   rl_redraw_prompt_last_line ();
+  _rl_frame_end ();
   rl_keep_mark_active ();
 }
 
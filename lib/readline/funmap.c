@@ -35,9 +35,10 @@
 #  include "ansi_stdlib.h"
 #endif /* HAVE_STDLIB_H */
 
-#include "rlconf.h"
+#include "rldefs.h"
 #include "readline.h"
 
+#include "rlprivate.h"
 #include "xmalloc.h"
 
 typedef int QSFUNC (const void *, const void *);
@@ -242,6 +243,75 @@ rl_initialize_funmap (void)
   funmap_program_specific_entry_start = i;
 }
 
+/* A hash index of the function map, so parsing an init file doesn't have
+   to compare each function name it sees against every name in the map.
+   Names are hashed with ASCII case folding; a lookup checks its answer with
+   _rl_stricmp and falls back to a linear search if it doesn't find one, so
+   the index never gives a different answer than searching FUNMAP would.
+   The index is rebuilt when entries have been added to the map. */
+static int *funmap_index;
+static size_t funmap_index_size;
+static int funmap_index_entries = -1;
+
+static size_t
+funmap_hash (const char *name)
+{
+  size_t h;
+  unsigned char c;
+
+  for (h = 0; (c = *name); name++)
+    h = h * 31 + ((c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c);
+  return h;
+}
+
+static void
+funmap_build_index (void)
+{
+  size_t h, mask;
+  int i, j;
+
+  for (funmap_index_size = 256; funmap_index_size < (size_t)funmap_entry * 2; funmap_index_size <<= 1)
+    ;
+  mask = funmap_index_size - 1;
+  funmap_index = (int *)xrealloc (funmap_index, funmap_index_size * sizeof (int));
+  for (h = 0; h < funmap_index_size; h++)
+    funmap_index[h] = -1;
+
+  /* If a name appears more than once, keep the first, which is the one a
+     linear search finds. */
+  for (i = 0; i < funmap_entry; i++)
+    {
+      for (h = funmap_hash (funmap[i]->name) & mask; (j = funmap_index[h]) >= 0; h = (h + 1) & mask)
+	if (_rl_stricmp (funmap[j]->name, funmap[i]->name) == 0)
+	  break;
+      if (j < 0)
+	funmap_index[h] = i;
+    }
+  funmap_index_entries = funmap_entry;
+}
+
+rl_command_func_t *
+_rl_funmap_lookup (const char *string)
+{
+  size_t h, mask;
+  int i;
+
+  rl_initialize_funmap ();
+
+  if (funmap_index_entries != funmap_entry)
+    funmap_build_index ();
+
+  mask = funmap_index_size - 1;
+  for (h = funmap_hash (string) & mask; (i = funmap_index[h]) >= 0; h = (h + 1) & mask)
+    if (i < funmap_entry && funmap[i] && _rl_stricmp (funmap[i]->name, string) == 0)
+      return (funmap[i]->function);
+
+  for (i = 0; funmap[i]; i++)
+    if (_rl_stricmp (funmap[i]->name, string) == 0)
+      return (funmap[i]->function);
+  return ((rl_command_func_t *)NULL);
+}
+
 /* Produce a NULL terminated array of known function names.  The array
    is sorted.  The array itself is allocated, but not the strings inside.
    You should free () the array when you done, but not the pointers. */
@@ -145,6 +145,30 @@ static int histfile_backup (const char *, const char *);
 static int histfile_restore (const char *, const char *);
 static int history_rename (const char *, const char *);
 
+static int hist_journal_resume (int, const char *, struct stat *, int);
+static void hist_journal_record (const char *, struct stat *, off_t, int, int);
+static void hist_journal_clear (void);
+static int hist_count_lines (const char *, size_t, int);
+
+/* What we know about the end of the history file we most recently read
+   or appended to: its identity, the offset just past the last complete
+   line, and the number of lines before that offset.  Other shells only
+   append to the file until someone truncates or rewrites it, so as long
+   as the file is the same one and has not shrunk, the lines after OFFSET
+   are the lines added since we last looked.  read_history_range uses
+   this to read only those lines and history_truncate_file uses it to
+   avoid reading a file it knows is short enough. */
+typedef struct _hist_journal {
+  char *name;
+  dev_t dev;
+  ino_t ino;
+  off_t offset;
+  int lines;
+  int tschar;		/* timestamp comment character, 0 if no timestamps */
+} HIST_JOURNAL;
+
+static HIST_JOURNAL history_journal;
+
 /* Return the string that should be used in the place of this
    filename.  This only matters when you don't specify the
    filename to read_history (), or write_history (). */
@@ -249,6 +273,80 @@ history_tempfile (const char *filename)
   return ret;
 }
   
+static void
+hist_journal_clear (void)
+{
+  FREE (history_journal.name);
+  history_journal.name = (char *)NULL;
+  history_journal.offset = 0;
+  history_journal.lines = 0;
+  history_journal.tschar = 0;
+}
+
+/* Record that the first OFFSET bytes of FILENAME, whose status is FINFO,
+   hold LINES complete lines.  TSCHAR is the character that starts timestamp
+   lines in the file, or 0 if it does not contain timestamps. */
+static void
+hist_journal_record (const char *filename, struct stat *finfo, off_t offset, int lines, int tschar)
+{
+  if (S_ISREG (finfo->st_mode) == 0 || finfo->st_size < offset)
+    {
+      hist_journal_clear ();
+      return;
+    }
+
+  if (history_journal.name == 0 || STREQ (history_journal.name, filename) == 0)
+    {
+      FREE (history_journal.name);
+      history_journal.name = savestring (filename);
+    }
+  history_journal.dev = finfo->st_dev;
+  history_journal.ino = finfo->st_ino;
+  history_journal.offset = offset;
+  history_journal.lines = lines;
+  history_journal.tschar = tschar;
+}
+
+/* If the caller wants the lines of FILENAME, open on FD with status FINFO,
+   starting at line FROM, and the journal says where that line starts,
+   leave FD positioned at history_journal.offset and return 1.  Read the
+   byte that precedes the offset as a check that the file has not been
+   rewritten with different contents.  Return 0 if the caller has to read
+   the whole file. */
+static int
+hist_journal_resume (int fd, const char *filename, struct stat *finfo, int from)
+{
+  char c;
+
+  if (from <= 0 || from != history_journal.lines || history_journal.offset <= 0 ||
+      history_journal.name == 0 || STREQ (history_journal.name, filename) == 0 ||
+      history_journal.dev != finfo->st_dev || history_journal.ino != finfo->st_ino ||
+      history_journal.offset > finfo->st_size)
+    return 0;
+
+  if (lseek (fd, history_journal.offset - 1, SEEK_SET) < 0 || read (fd, &c, 1) != 1 || c != '\n')
+    {
+      lseek (fd, 0, SEEK_SET);
+      return 0;
+    }
+  return 1;
+}
+
+/* Return the number of complete lines in the LEN bytes at S that are not
+   timestamps starting with TSCHAR, counting them the way read_history_range
+   does. */
+static int
+hist_count_lines (const char *s, size_t len, int tschar)
+{
+  const char *p, *end;
+  int lines;
+
+  for (lines = 0, end = s + len; s < end && (p = (const char *)memchr (s, '\n', end - s)); s = p + 1)
+    if (tschar == 0 || s[0] != tschar || isdigit ((unsigned char)s[1]) == 0)
+      lines++;
+  return lines;
+}
+
 /* Add the contents of FILENAME to the history list, a line at a time.
    If FILENAME is NULL, then read from ~/.history.  Returns 0 if
    successful, or errno if not. */
@@ -269,9 +367,13 @@ read_history_range (const char *filename, int from, int to)
   register char *line_start, *line_end, *p;
   char *input, *buffer, *bufend, *last_ts;
   int file, current_line, chars_read, has_timestamps, reset_comment_char;
-  int skipblanks, default_skipblanks;
+  int skipblanks, default_skipblanks, readall;
   struct stat finfo;
   size_t file_size;
+  off_t skip;
+#ifdef HISTORY_USE_MMAP
+  char *mapbase;
+#endif
 #if defined (EFBIG)
   int overflow_errno = EFBIG;
 #elif defined (EOVERFLOW)
@@ -321,25 +423,30 @@ read_history_range (const char *filename, int from, int to)
 	}
     }
 
+  /* If we know where line FROM starts because we read or appended up to
+     it earlier, read only the lines after it. */
+  skip = hist_journal_resume (file, input, &finfo, from) ? history_journal.offset : 0;
+
 #ifdef HISTORY_USE_MMAP
   /* We map read/write and private so we can change newlines to NULs without
      affecting the underlying object. */
-  buffer = (char *)mmap (0, file_size, PROT_READ|PROT_WRITE, MAP_RFLAGS, file, 0);
-  if ((void *)buffer == MAP_FAILED)
+  mapbase = (char *)mmap (0, file_size, PROT_READ|PROT_WRITE, MAP_RFLAGS, file, 0);
+  if ((void *)mapbase == MAP_FAILED)
     {
       errno = overflow_errno;
       goto error_and_exit;
     }
-  chars_read = file_size;
+  buffer = mapbase + skip;
+  chars_read = file_size - skip;
 #else
-  buffer = (char *)malloc (file_size + 1);
+  buffer = (char *)malloc (file_size - skip + 1);
   if (buffer == 0)
     {
       errno = overflow_errno;
       goto error_and_exit;
     }
 
-  chars_read = read (file, buffer, file_size);
+  chars_read = read (file, buffer, file_size - skip);
 #endif
   if (chars_read < 0)
     {
@@ -362,25 +469,33 @@ read_history_range (const char *filename, int from, int to)
   close (file);
 
   /* Set TO to larger than end of file if negative. */
+  readall = to < 0;
   if (to < 0)
-    to = chars_read;
+    to = skip + chars_read;
 
-  /* Start at beginning of file, work to end. */
+  /* Start at beginning of file, or at the first line we haven't read, and
+     work to end. */
   bufend = buffer + chars_read;
   *bufend = '\0';		/* null-terminate buffer for timestamp checks */
-  current_line = 0;
+  current_line = skip ? from : 0;
 
   /* Heuristic: the history comment character rarely changes, so assume we
      have timestamps if the buffer starts with `#[:digit:]' and temporarily
-     set history_comment_char so timestamp parsing works right */
+     set history_comment_char so timestamp parsing works right.  If we're
+     not starting at the beginning, use what we found there last time. */
   reset_comment_char = 0;
-  if (history_comment_char == '\0' && buffer[0] == '#' && isdigit ((unsigned char)buffer[1]))
+  if (history_comment_char == '\0' && skip && history_journal.tschar)
+    {
+      history_comment_char = history_journal.tschar;
+      reset_comment_char = 1;
+    }
+  else if (history_comment_char == '\0' && skip == 0 && buffer[0] == '#' && isdigit ((unsigned char)buffer[1]))
     {
       history_comment_char = '#';
       reset_comment_char = 1;
     }
 
-  has_timestamps = HIST_TIMESTAMP_START (buffer);
+  has_timestamps = skip ? (history_journal.tschar != 0) : HIST_TIMESTAMP_START (buffer);
   history_multiline_entries += has_timestamps && history_write_timestamps;
 
   /* default is to skip blank lines unless history entries are multiline */
@@ -462,6 +577,13 @@ read_history_range (const char *filename, int from, int to)
       }
 
   history_lines_read_from_file = current_line;
+
+  /* Remember where the lines we read end so the next read of this file can
+     start there. */
+  if (readall)
+    hist_journal_record (input, &finfo, skip + (line_start - buffer), current_line,
+			 has_timestamps ? history_comment_char : 0);
+
   if (reset_comment_char)
     history_comment_char = '\0';
 
@@ -469,7 +591,7 @@ read_history_range (const char *filename, int from, int to)
 #ifndef HISTORY_USE_MMAP
   FREE (buffer);
 #else
-  munmap (buffer, file_size);
+  munmap (mapbase, file_size);
 #endif
 
   return (0);
@@ -596,6 +718,17 @@ history_truncate_file (const char *fname, int lines)
       goto truncate_exit;
     }
 
+  /* If we were the last to read or append to the file, we know how many
+     lines it has and don't need to read it to find out it's short enough. */
+  if (lines > 0 && history_journal.name && STREQ (history_journal.name, filename) &&
+      history_journal.dev == finfo.st_dev && history_journal.ino == finfo.st_ino &&
+      history_journal.offset == finfo.st_size && history_journal.lines <= lines)
+    {
+      close (file);
+      lines -= history_journal.lines;
+      goto truncate_exit;
+    }
+
   buffer = (char *)malloc (file_size + 1);
   if (buffer == 0)
     {
@@ -698,6 +831,11 @@ truncate_write:
   if (rv == 0 && filename && tempname)
     rv = histfile_restore (tempname, filename);
 
+  /* We just replaced the file, so its lines no longer start where we
+     recorded. */
+  if (rv == 0 && tempname)
+    hist_journal_clear ();
+
   if (rv != 0)
     {
       rv = errno;
@@ -761,8 +899,9 @@ history_do_write (const char *filename, int nelements, int overwrite)
 {
   register int i;
   char *output, *tempname, *histname;
-  int file, mode, rv, exists;
-  struct stat finfo;
+  int file, mode, rv, exists, nlines, tschar;
+  struct stat finfo, ninfo;
+  off_t startsize, nbytes;
 #ifdef HISTORY_USE_MMAP
   size_t cursize, newsize;
   off_t offset;
@@ -796,6 +935,13 @@ history_do_write (const char *filename, int nelements, int overwrite)
 #ifdef HISTORY_USE_MMAP
   cursize = overwrite ? 0 : lseek (file, 0, SEEK_END);
 #endif
+  /* Overwriting the file invalidates what we know about where its lines
+     end. */
+  if (overwrite)
+    hist_journal_clear ();
+  startsize = (overwrite == 0 && fstat (file, &ninfo) == 0) ? ninfo.st_size : -1;
+  nlines = tschar = 0;
+  nbytes = 0;
 
   if (nelements > history_length)
     nelements = history_length;
@@ -861,6 +1007,11 @@ mmap_error:
       {
 	if (history_write_timestamps && the_history[i]->timestamp && the_history[i]->timestamp[0])
 	  {
+	    /* Remember whether read_history_range will treat this as a
+	       timestamp */
+	    if (i == history_length - nelements && isdigit ((unsigned char)the_history[i]->timestamp[1]) &&
+		the_history[i]->timestamp[0] == (history_comment_char ? history_comment_char : '#'))
+	      tschar = the_history[i]->timestamp[0];
 	    strcpy (buffer + j, the_history[i]->timestamp);
 	    j += strlen (the_history[i]->timestamp);
 	    buffer[j++] = '\n';
@@ -869,6 +1020,16 @@ mmap_error:
 	j += strlen (the_history[i]->line);
 	buffer[j++] = '\n';
       }
+    /* Count the lines the way read_history_range will when it reads them
+       back: an appended timestamp uses the convention of the file. */
+    if (overwrite == 0)
+      tschar = history_journal.tschar;
+#ifdef HISTORY_USE_MMAP
+    nlines = hist_count_lines (buffer + cursize - offset, buffer_size, tschar);
+#else
+    nlines = hist_count_lines (buffer, buffer_size, tschar);
+#endif
+    nbytes = buffer_size;
 
 #ifdef HISTORY_USE_MMAP
     /* make sure we unmap the pages even if the sync fails */
@@ -881,6 +1042,15 @@ mmap_error:
       rv = errno;
     xfree (buffer);
 #endif
+
+    /* If nobody else appended to the file since we last read or wrote it,
+       and nobody appended while we were writing, the lines we just wrote
+       are the last ones we know about. */
+    if (rv == 0 && startsize >= 0 && startsize == history_journal.offset &&
+	history_journal.name && STREQ (history_journal.name, histname) &&
+	fstat (file, &ninfo) == 0 && ninfo.st_size == startsize + buffer_size &&
+	history_journal.dev == ninfo.st_dev && history_journal.ino == ninfo.st_ino)
+      hist_journal_record (histname, &ninfo, ninfo.st_size, history_journal.lines + nlines, tschar);
   }
 
   history_lines_written_to_file = nelements;
@@ -892,6 +1062,10 @@ write_success:
   if (rv == 0 && histname && tempname)
     rv = histfile_restore (tempname, histname);
 
+  /* We just wrote the whole file, so we know where it ends. */
+  if (rv == 0 && overwrite && histname && nlines > 0 && stat (histname, &ninfo) == 0)
+    hist_journal_record (histname, &ninfo, nbytes, nlines, tschar);
+
   if (rv != 0)
     {
       rv = errno;
@@ -91,6 +91,12 @@ extern void _hs_replace_history_data (int, histdata_t *, histdata_t *);
 extern int _hs_search_history_data (histdata_t *);
 extern int _hs_at_end_of_history (void);
 
+/* The number of unsigned ints in a history line signature */
+#define HIST_SIG_WORDS	4
+
+extern int _hs_search_signature (const char *, size_t, int, unsigned int *);
+extern int _hs_history_candidate (int, int, const unsigned int *);
+
 /* histfile.c */
 extern void _hs_append_history_line (int, const char *);
 
@@ -69,6 +69,20 @@ static int history_list_grow_size (void);
 static void history_list_resize (int);		/* XXX - size_t? */
 static void advance_history (void);
 
+static unsigned int hist_line_hash (const char *);
+static void hist_index_insert (HIST_ENTRY *, int);
+static void hist_index_delete (HIST_ENTRY *);
+static void hist_index_build (void);
+static void hist_index_flush (void);
+
+static void hist_sig_compute (const char *, size_t, int, unsigned int *);
+static void hist_sig_reserve (int);
+static void hist_sig_set (int);
+static void hist_sig_remove (int, int);
+static void hist_sig_rebase (void);
+static void hist_sig_build (void);
+static void hist_sig_flush (void);
+
 /* **************************************************************** */
 /*								    */
 /*			History Functions			    */
@@ -112,6 +126,47 @@ int history_length;
 /* The logical `base' of the history array.  It defaults to 1. */
 int history_base = 1;
 
+/* An index of the history list by line contents, so we can find the entries
+   with a particular line without comparing it to every line in the list.
+   It's built the first time someone searches for a line and kept current
+   by the functions in this file that add, replace, and remove entries.
+   Each node remembers where its entry was, relative to history_base; entries
+   only move toward the start of the list, so that is where we begin looking
+   for the entry's current offset. */
+typedef struct _hist_index_node {
+  struct _hist_index_node *next;
+  HIST_ENTRY *entry;
+  unsigned int hash;
+  int where;			/* offset + history_base when last seen */
+} HIST_INDEX_NODE;
+
+static HIST_INDEX_NODE **history_index = (HIST_INDEX_NODE **)NULL;
+static int history_index_size;		/* number of buckets, a power of two */
+static int history_index_count;		/* number of entries indexed */
+
+#define HISTORY_INDEX_INITIAL_SIZE	1024
+
+/* Non-zero means that history searches use signatures of the history lines
+   to skip entries that cannot contain the search string. */
+int history_search_index = 1;
+
+/* The signature of a history line: a bit is set for each pair of adjacent
+   bytes in the line, after folding ASCII letters to lowercase.  A line can
+   only contain a string if its signature has all the bits in the string's
+   signature.  history_sigs[history_sigs_start + i] is the signature of
+   the_history[i]; it's built by the first search and moved along with the
+   entries. */
+#define HIST_SIG_BITS	(HIST_SIG_WORDS * 32)
+
+typedef struct _hist_sig {
+  HIST_ENTRY *entry;		/* the entry this describes */
+  unsigned int bits[HIST_SIG_WORDS];
+} HIST_SIG;
+
+static HIST_SIG *history_sigs = (HIST_SIG *)NULL;
+static int history_sigs_start;
+static int history_sigs_size;
+
 /* Compute the number of bits required to store a given nonnegative integer.
 
    NOTE: _bit_length(0) == 0 */
@@ -186,6 +241,10 @@ history_set_history_state (HISTORY_STATE *state)
   history_size = state->size;
   if (state->flags & HS_STIFLED)
     history_stifled = 1;
+
+  /* We don't know anything about the entries in the new list */
+  hist_index_flush ();
+  hist_sig_flush ();
 }
 
 /* Begin a session in which the history functions might be used.  This
@@ -349,7 +408,10 @@ history_list_resize (int new_size)
   /* If we need to, reset the_history to the start of real_history and
      start over. */
   if (the_history != real_history)
-    memmove (real_history, the_history, history_length * sizeof (HIST_ENTRY *));
+    {
+      memmove (real_history, the_history, history_length * sizeof (HIST_ENTRY *));
+      hist_sig_rebase ();
+    }
 
   /* Don't bother if real_history_size is already big enough, since at this
      point the_history == real_history and we will set history_size to
@@ -372,6 +434,8 @@ advance_history (void)
   /* Advance 'the_history' pointer to simulate dropping the first entry. */
   the_history++;
   history_size--;
+  if (history_sigs)
+    history_sigs_start++;
 
   /* If full, move all the entries (and trailing NULL) to the beginning. */
   if (history_length == history_size)
@@ -395,7 +459,10 @@ add_history (const char *string)
 
       /* If there is something in the slot, then remove it. */
       if (the_history[0])
-	(void) free_history_entry (the_history[0]);
+	{
+	  hist_index_delete (the_history[0]);
+	  (void) free_history_entry (the_history[0]);
+	}
 
       /* Advance the pointer into real_history, resizing if necessary. */
       advance_history ();
@@ -430,6 +497,9 @@ add_history (const char *string)
   the_history[new_length] = (HIST_ENTRY *)NULL;
   the_history[new_length - 1] = temp;
   history_length = new_length;
+
+  hist_index_insert (temp, new_length - 1);
+  hist_sig_set (new_length - 1);
 }
 
 /* Change the time stamp of the most recent history entry to STRING. */
@@ -499,6 +569,10 @@ replace_history_entry (int which, const char *line, histdata_t data)
   temp->timestamp = old_value->timestamp ? savestring (old_value->timestamp) : 0;
   the_history[which] = temp;
 
+  hist_index_delete (old_value);
+  hist_index_insert (temp, which);
+  hist_sig_set (which);
+
   return (old_value);
 }
 
@@ -526,6 +600,7 @@ _hs_append_history_line (int which, const char *line)
     newlen = minlen;
   /* Assume that realloc returns the same pointer and doesn't try a new
      alloc/copy if the new size is the same as the one last passed. */
+  hist_index_delete (hent);
   newline = realloc (hent->line, newlen);
   if (newline)
     {
@@ -533,6 +608,8 @@ _hs_append_history_line (int which, const char *line)
       hent->line[curlen++] = '\n';
       strcpy (hent->line + curlen, line);
     }
+  hist_index_insert (hent, which);
+  hist_sig_set (which);
 }
 
 /* Replace the DATA in the specified history entries, replacing OLD with
@@ -616,6 +693,8 @@ remove_history (int which)
     return ((HIST_ENTRY *)NULL);
 
   return_value = the_history[which];
+  hist_index_delete (return_value);
+  hist_sig_remove (which, 1);
 
 #if 1
   /* Copy the rest of the entries, moving down one slot.  Copy includes
@@ -656,8 +735,12 @@ remove_history_range (int first, int last)
 
   /* Return all the deleted entries in a list */
   for (i = first ; i <= last; i++)
-    return_value[i - first] = the_history[i];
+    {
+      return_value[i - first] = the_history[i];
+      hist_index_delete (the_history[i]);
+    }
   return_value[i - first] = (HIST_ENTRY *)NULL;
+  hist_sig_remove (first, nentries);
 
   /* Copy the rest of the entries, moving down NENTRIES slots.  Copy includes
      trailing NULL.  */
@@ -683,9 +766,13 @@ stifle_history (int max)
     {
       /* This loses because we cannot free the data. */
       for (i = 0, j = history_length - max; i < j; i++)
-	free_history_entry (the_history[i]);
+	{
+	  hist_index_delete (the_history[i]);
+	  free_history_entry (the_history[i]);
+	}
 
       history_base = i;
+      hist_sig_remove (0, i);
       for (j = 0, i = history_length - max; j < max; i++, j++)
 	the_history[j] = the_history[i];
       the_history[j] = (HIST_ENTRY *)NULL;
@@ -731,4 +818,372 @@ clear_history (void)
 
   history_offset = history_length = 0;
   history_base = 1;		/* reset history base to default */
+
+  hist_index_flush ();
+  hist_sig_flush ();
+}
+
+/* **************************************************************** */
+/*								    */
+/*			History Line Index			    */
+/*								    */
+/* **************************************************************** */
+
+/* FNV-1a */
+#define FNV_OFFSET 2166136261
+#define FNV_PRIME 16777619
+
+static unsigned int
+hist_line_hash (const char *s)
+{
+  register unsigned int i;
+
+  for (i = FNV_OFFSET; s && *s; s++)
+    {
+      i ^= (unsigned char)*s;
+      i *= FNV_PRIME;
+    }
+  return i;
+}
+
+/* Add ENTRY, which is at offset WHICH in the history list, to the index.
+   This does nothing if the index has not been built. */
+static void
+hist_index_insert (HIST_ENTRY *entry, int which)
+{
+  HIST_INDEX_NODE *node, **bucket, **nindex, *next;
+  int i, nsize;
+
+  if (history_index == 0 || entry == 0)
+    return;
+
+  /* Keep the average chain length under two */
+  if (history_index_count >= history_index_size * 2)
+    {
+      nsize = history_index_size * 2;
+      nindex = (HIST_INDEX_NODE **)xmalloc (nsize * sizeof (HIST_INDEX_NODE *));
+      memset (nindex, 0, nsize * sizeof (HIST_INDEX_NODE *));
+      for (i = 0; i < history_index_size; i++)
+	for (node = history_index[i]; node; node = next)
+	  {
+	    next = node->next;
+	    bucket = nindex + (node->hash & (nsize - 1));
+	    node->next = *bucket;
+	    *bucket = node;
+	  }
+      xfree (history_index);
+      history_index = nindex;
+      history_index_size = nsize;
+    }
+
+  node = (HIST_INDEX_NODE *)xmalloc (sizeof (HIST_INDEX_NODE));
+  node->entry = entry;
+  node->hash = hist_line_hash (entry->line);
+  node->where = which + history_base;
+  bucket = history_index + (node->hash & (history_index_size - 1));
+  node->next = *bucket;
+  *bucket = node;
+  history_index_count++;
+}
+
+/* Remove ENTRY from the index, if it's there. */
+static void
+hist_index_delete (HIST_ENTRY *entry)
+{
+  HIST_INDEX_NODE *node, **prev;
+
+  if (history_index == 0 || entry == 0)
+    return;
+
+  prev = history_index + (hist_line_hash (entry->line) & (history_index_size - 1));
+  for (node = *prev; node; prev = &node->next, node = node->next)
+    if (node->entry == entry)
+      {
+	*prev = node->next;
+	xfree (node);
+	history_index_count--;
+	return;
+      }
+}
+
+/* Index the current history list. */
+static void
+hist_index_build (void)
+{
+  int i;
+
+  hist_index_flush ();
+
+  history_index_size = HISTORY_INDEX_INITIAL_SIZE;
+  while (history_index_size < history_length)
+    history_index_size <<= 1;
+  history_index = (HIST_INDEX_NODE **)xmalloc (history_index_size * sizeof (HIST_INDEX_NODE *));
+  memset (history_index, 0, history_index_size * sizeof (HIST_INDEX_NODE *));
+  history_index_count = 0;
+
+  for (i = 0; i < history_length; i++)
+    hist_index_insert (the_history[i], i);
+}
+
+/* Throw away the index; the next search will rebuild it. */
+static void
+hist_index_flush (void)
+{
+  HIST_INDEX_NODE *node, *next;
+  int i;
+
+  if (history_index == 0)
+    return;
+
+  for (i = 0; i < history_index_size; i++)
+    for (node = history_index[i]; node; node = next)
+      {
+	next = node->next;
+	xfree (node);
+      }
+  xfree (history_index);
+  history_index = (HIST_INDEX_NODE **)NULL;
+  history_index_size = history_index_count = 0;
+}
+
+/* Return the current offset in the history list of NODE's entry, or -1 if
+   it's no longer in the list.  This only compares pointers; it never looks
+   at the entry itself. */
+static int
+hist_index_offset (HIST_INDEX_NODE *node)
+{
+  int i, start;
+
+  start = node->where - history_base;
+  if (start >= history_length)
+    start = history_length - 1;
+
+  for (i = start; i >= 0; i--)
+    if (the_history[i] == node->entry)
+      break;
+
+  if (i < 0)
+    {
+      /* The application changed history_base behind our back */
+      for (i = history_length - 1; i > start; i--)
+	if (the_history[i] == node->entry)
+	  break;
+      if (i == start)
+	return -1;
+    }
+
+  node->where = i + history_base;
+  return i;
+}
+
+/* Return the offset of the most recent history entry whose line is exactly
+   LINE, or -1 if there is no such entry.  This builds the line index if
+   necessary, so each search after the first takes constant time on average
+   rather than time proportional to the length of the history list. */
+int
+history_search_line (const char *line)
+{
+  HIST_INDEX_NODE *node, **prev;
+  unsigned int hash;
+  int i, ret;
+
+  if (line == 0 || the_history == 0 || history_length == 0)
+    return -1;
+
+  if (history_index == 0)
+    hist_index_build ();
+
+  hash = hist_line_hash (line);
+  ret = -1;
+  prev = history_index + (hash & (history_index_size - 1));
+  while (node = *prev)
+    {
+      if (node->hash != hash)
+	{
+	  prev = &node->next;
+	  continue;
+	}
+      i = hist_index_offset (node);
+      if (i < 0)
+	{
+	  /* The entry was freed without telling us; forget it */
+	  *prev = node->next;
+	  xfree (node);
+	  history_index_count--;
+	  continue;
+	}
+      if (i > ret && STREQ (node->entry->line, line))
+	ret = i;
+      prev = &node->next;
+    }
+
+  return ret;
+}
+
+/* Return the number of bytes of memory used by the indexes of the history
+   list: the line index and the line signatures. */
+int
+history_index_bytes (void)
+{
+  return (history_index_size * sizeof (HIST_INDEX_NODE *) +
+	  history_index_count * sizeof (HIST_INDEX_NODE) +
+	  history_sigs_size * sizeof (HIST_SIG));
+}
+
+/* Compute the signature of the first LEN bytes of S into BITS.  If
+   SKIPHIGH is non-zero, ignore pairs containing bytes with the eighth bit
+   set, since a case-insensitive search in a single-byte locale may match
+   them with different bytes. */
+static void
+hist_sig_compute (const char *s, size_t len, int skiphigh, unsigned int *bits)
+{
+  unsigned int a, b, h;
+  size_t i;
+
+  memset (bits, 0, HIST_SIG_WORDS * sizeof (unsigned int));
+  for (i = 1; i < len; i++)
+    {
+      a = (unsigned char)s[i - 1];
+      b = (unsigned char)s[i];
+      if (skiphigh && (a >= 0x80 || b >= 0x80))
+	continue;
+      if (a >= 'A' && a <= 'Z')
+	a += 'a' - 'A';
+      if (b >= 'A' && b <= 'Z')
+	b += 'a' - 'A';
+      h = (((a << 8) | b) * 2654435761U) >> 25;
+      h &= HIST_SIG_BITS - 1;
+      bits[h >> 5] |= 1U << (h & 31);
+    }
+}
+
+/* Make sure there is room for signatures of N entries past
+   history_sigs_start. */
+static void
+hist_sig_reserve (int n)
+{
+  int nsize;
+
+  if (history_sigs_start + n <= history_sigs_size)
+    return;
+  nsize = history_sigs_size ? history_sigs_size : DEFAULT_HISTORY_GROW_SIZE;
+  while (nsize < history_sigs_start + n)
+    nsize *= 2;
+  history_sigs = (HIST_SIG *)xrealloc (history_sigs, nsize * sizeof (HIST_SIG));
+  history_sigs_size = nsize;
+}
+
+/* Compute the signature of the history entry at offset WHICH. */
+static void
+hist_sig_set (int which)
+{
+  HIST_SIG *sig;
+  HIST_ENTRY *entry;
+
+  if (history_sigs == 0)
+    return;
+
+  hist_sig_reserve (which + 1);
+  sig = history_sigs + history_sigs_start + which;
+  sig->entry = entry = the_history[which];
+  hist_sig_compute (entry->line, strlen (entry->line), 0, sig->bits);
+}
+
+/* The N entries starting at offset FIRST are being removed from the
+   history list; remove their signatures.  Call this before changing
+   history_length. */
+static void
+hist_sig_remove (int first, int n)
+{
+  HIST_SIG *start;
+
+  if (history_sigs == 0 || n <= 0)
+    return;
+
+  start = history_sigs + history_sigs_start;
+  memmove (start + first, start + first + n, (history_length - first - n) * sizeof (HIST_SIG));
+}
+
+/* The entries in the history list are being moved to the beginning of
+   the array; do the same with their signatures. */
+static void
+hist_sig_rebase (void)
+{
+  if (history_sigs == 0 || history_sigs_start == 0)
+    return;
+
+  memmove (history_sigs, history_sigs + history_sigs_start, history_length * sizeof (HIST_SIG));
+  history_sigs_start = 0;
+}
+
+static void
+hist_sig_build (void)
+{
+  int i;
+
+  hist_sig_flush ();
+
+  history_sigs_start = 0;
+  hist_sig_reserve (history_length + DEFAULT_HISTORY_GROW_SIZE);
+  for (i = 0; i < history_length; i++)
+    hist_sig_set (i);
+}
+
+static void
+hist_sig_flush (void)
+{
+  FREE (history_sigs);
+  history_sigs = (HIST_SIG *)NULL;
+  history_sigs_start = history_sigs_size = 0;
+}
+
+/* Compute the signature of the LEN-byte search string STRING, to be passed
+   to _hs_history_candidate.  FLAGS are the history search flags.  Returns
+   0 if the signature can't be used to rule out any entries.  That includes
+   case-insensitive searches in a multibyte locale, which fold wide
+   characters and can match a multibyte character in an entry with an
+   ASCII one in STRING (KELVIN SIGN and `k', for instance). */
+int
+_hs_search_signature (const char *string, size_t len, int flags, unsigned int *bits)
+{
+  int i;
+
+  if (history_search_index == 0 || (flags & PATTERN_SEARCH) || len < 2)
+    return 0;
+  if ((flags & CASEFOLD_SEARCH) && MB_CUR_MAX > 1)
+    return 0;
+
+  hist_sig_compute (string, len, flags & CASEFOLD_SEARCH, bits);
+  for (i = 0; i < HIST_SIG_WORDS; i++)
+    if (bits[i])
+      return 1;
+  return 0;
+}
+
+/* Return the offset of the first history entry, starting at FROM and
+   moving in direction DIR, whose line might contain a string with signature
+   BITS.  Returns -1 or history_length if there is no such entry.  Entries
+   whose signatures don't match the list (because the application changed
+   it behind our back) are always returned. */
+int
+_hs_history_candidate (int from, int dir, const unsigned int *bits)
+{
+  HIST_SIG *sig;
+  int i, w;
+
+  if (history_sigs == 0)
+    hist_sig_build ();
+
+  for (i = from; i >= 0 && i < history_length; i += dir)
+    {
+      sig = history_sigs + history_sigs_start + i;
+      if (history_sigs_start + i >= history_sigs_size || sig->entry != the_history[i])
+	return i;
+      for (w = 0; w < HIST_SIG_WORDS; w++)
+	if ((sig->bits[w] & bits[w]) != bits[w])
+	  break;
+      if (w == HIST_SIG_WORDS)
+	return i;
+    }
+  return i;
 }
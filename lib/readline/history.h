@@ -155,6 +155,10 @@ extern time_t history_get_time (HIST_ENTRY *);
    This just adds up the lengths of the_history->lines. */
 extern int history_total_bytes (void);
 
+/* Return the number of bytes of memory used by the indexes the history
+   library keeps to speed up searching the history list. */
+extern int history_index_bytes (void);
+
 /* Moving around the history list. */
 
 /* Set the position in the history list to POS. */
@@ -172,6 +176,14 @@ extern HIST_ENTRY *next_history (void);
 
 /* Searching the history list. */
 
+/* Return the offset of the most recent entry in the history list whose
+   line is exactly STRING, or -1 if there isn't one.  The first call
+   builds an index of the history list that is kept current as entries
+   are added, replaced, and removed, so subsequent calls don't have to
+   look at every entry.  Applications must change history lines with
+   replace_history_entry() rather than modifying them in place. */
+extern int history_search_line (const char *);
+
 /* Search the history for STRING, starting at history_offset.
    If DIRECTION < 0, then the search is through previous entries,
    else through subsequent.  If the string is found, then
@@ -272,6 +284,8 @@ extern int history_quoting_state;
 
 extern int history_write_timestamps;
 
+extern int history_search_index;
+
 /* These two are undocumented; the second is reserved for future use */
 extern int history_multiline_entries;
 extern int history_file_version;
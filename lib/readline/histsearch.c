@@ -79,6 +79,8 @@ history_search_internal (const char *string, int listdir, int linedir, int flags
   int line_index;		/* can't be unsigned */
   int anchored, patsearch, igncase;
   int found, mb_cur_max;
+  int usesig;
+  unsigned int sig[HIST_SIG_WORDS];
   HIST_ENTRY **the_history; 	/* local */
 
   i = history_offset;
@@ -107,9 +109,15 @@ history_search_internal (const char *string, int listdir, int linedir, int flags
 
   the_history = history_list ();
   string_len = strlen (string);
+
+  /* Skip lines whose signatures say they can't contain STRING */
+  usesig = _hs_search_signature (string, string_len, (flags & ~PATTERN_SEARCH) | patsearch, sig);
+
   while (1)
     {
       /* Search each line in the history list for STRING. */
+      if (usesig)
+	i = _hs_history_candidate (i, reverse ? -1 : 1, sig);
 
       /* At limit for direction? */
       if ((reverse && i < 0) || (!reverse && i == history_length))
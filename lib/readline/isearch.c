@@ -54,6 +54,8 @@
 #include "rlprivate.h"
 #include "xmalloc.h"
 
+#include "histlib.h"
+
 /* Variables exported to other files in the readline library. */
 char *_rl_isearch_terminators = (char *)NULL;
 
@@ -345,7 +347,8 @@ _rl_isearch_dispatch (_rl_search_cxt *cxt, int c)
   int n, wstart, wlen, limit, cval;
   char *paste;
   size_t pastelen;
-  int j;
+  int j, usesig;
+  unsigned int sig[HIST_SIG_WORDS];
   rl_command_func_t *f;
 
   f = (rl_command_func_t *)NULL;
@@ -770,6 +773,10 @@ opcode_dispatch:
       break;
     }
 
+  /* Use the history line signatures to skip lines that can't match */
+  usesig = _hs_search_signature (cxt->search_string, cxt->search_string_index,
+				 _rl_search_case_fold ? CASEFOLD_SEARCH : 0, sig);
+
   for (cxt->sflags &= ~(SF_FOUND|SF_FAILED);; )
     {
       if (cxt->search_string_index == 0)
@@ -827,6 +834,8 @@ opcode_dispatch:
 	{
 	  /* Move to the next line. */
 	  cxt->history_pos += cxt->direction;
+	  if (usesig && cxt->history_pos >= 0 && cxt->history_pos < history_length)
+	    cxt->history_pos = _hs_history_candidate (cxt->history_pos, cxt->direction, sig);
 
 	  /* At limit for direction? */
 	  if ((cxt->sflags & SF_REVERSE) ? (cxt->history_pos < 0) : (cxt->history_pos == cxt->hlen))
@@ -499,9 +499,10 @@ _rl_revert_previous_lines (void)
 	  while (rl_undo_list)
 	    rl_do_undo ();
 	  /* And copy the reverted line back to the history entry, preserving
-	     the timestamp. */
-	  FREE (entry->line);
-	  entry->line = savestring (rl_line_buffer);
+	     the timestamp.  replace_history_entry keeps the history index
+	     up to date; ENTRY is freed and not used again. */
+	  entry = replace_history_entry (where_history (), rl_line_buffer, (histdata_t)0);
+	  _rl_free_history_entry (entry);
 	}
       entry = previous_history ();
     }
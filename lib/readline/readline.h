@@ -593,6 +593,11 @@ extern const char *rl_terminal_name;
 extern FILE *rl_instream;
 extern FILE *rl_outstream;
 
+/* The number of bytes rl_redisplay sent to rl_outstream the last time it
+   was called, and the number of writes it used to send them. */
+extern int rl_redisplay_output_bytes;
+extern int rl_redisplay_output_writes;
+
 /* If non-zero, Readline gives values of LINES and COLUMNS from the environment
    greater precedence than values fetched from the kernel when computing the
    screen dimensions. */
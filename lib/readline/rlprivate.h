@@ -316,6 +316,9 @@ extern void _rl_erase_entire_line (void);
 extern int _rl_current_display_line (void);
 extern void _rl_refresh_line (void);
 
+/* funmap.c */
+extern rl_command_func_t *_rl_funmap_lookup (const char *);
+
 /* input.c */
 extern int _rl_any_typein (void);
 extern int _rl_input_available (void);
@@ -462,6 +465,9 @@ extern int _rl_output_character_function (int);
 #endif
 extern void _rl_cr (void);
 extern void _rl_output_some_chars (const char *, int);
+extern void _rl_frame_begin (void);
+extern void _rl_frame_flush (void);
+extern void _rl_frame_end (void);
 extern int _rl_backspace (int);
 extern void _rl_enable_meta_key (void);
 extern void _rl_disable_meta_key (void);
@@ -520,6 +526,8 @@ extern char *_rl_strindex (const char *, const char *);
 extern int _rl_strcaseeqn (const char *, const char *, size_t, int);
 extern int _rl_charcasecmp (int, int, int);
 extern int _rl_qsort_string_compare (char **, char **);
+extern void _rl_sort_strings (char **, size_t);
+extern void _rl_sort_strings_prefix (char **, size_t, size_t);
 extern int (_rl_uppercase_p) (int);
 extern int (_rl_lowercase_p) (int);
 extern int (_rl_pure_alphabetic) (int);
@@ -568,6 +576,7 @@ extern int _rl_completion_case_fold;
 extern int _rl_completion_case_map;
 extern int _rl_match_hidden_files;
 extern int _rl_page_completions;
+extern int _rl_page_completions_incrementally;
 extern int _rl_skip_completed_text;
 extern int _rl_menu_complete_prefix_first;
 
@@ -654,6 +663,7 @@ extern int _rl_susp_char;
 /* terminal.c */
 extern int _rl_enable_keypad;
 extern int _rl_enable_meta;
+extern int _rl_enable_synchronized_output;
 extern char *_rl_term_clreol;
 extern char *_rl_term_clrpag;
 extern char *_rl_term_clrscroll;
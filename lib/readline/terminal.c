@@ -47,6 +47,7 @@
 #endif
 
 #include <stdio.h>
+#include <errno.h>
 
 /* System-specific feature definitions and include files. */
 #include "rldefs.h"
@@ -224,6 +225,29 @@ int _rl_enable_keypad;
 /* Non-zero means the user wants to enable a meta key. */
 int _rl_enable_meta = 1;
 
+/* Non-zero means the user wants each redisplay wrapped in the sequences
+   that ask the terminal to update the screen all at once. */
+int _rl_enable_synchronized_output = 0;
+
+/* The number of bytes and the number of writes to rl_outstream the most
+   recent redisplay used. */
+int rl_redisplay_output_bytes;
+int rl_redisplay_output_writes;
+
+/* While rl_frame_depth is non-zero, the output functions below collect
+   their output in rl_frame_buffer, and _rl_frame_end writes it all to
+   _rl_out_stream at once, so a redisplay reaches the terminal in a
+   single write instead of one write per cursor motion or character on
+   an unbuffered stream. */
+static char *rl_frame_buffer;
+static size_t rl_frame_len, rl_frame_size, rl_frame_start;
+static int rl_frame_depth;
+
+#define SYNC_OUTPUT_BEGIN	"\033[?2026h"
+#define SYNC_OUTPUT_END		"\033[?2026l"
+
+static void rl_frame_append (const char *, size_t);
+
 /* Non-zero means this is an ANSI-compatible terminal; assume it is. */
 int _rl_term_isansi = RL_ANSI_TERM_DEFAULT;
 
@@ -802,17 +826,115 @@ rl_reset_terminal (const char *terminal_name)
   return 0;
 }
 
+static void
+rl_frame_append (const char *string, size_t count)
+{
+  if (rl_frame_len + count > rl_frame_size)
+    {
+      while (rl_frame_len + count > rl_frame_size)
+	rl_frame_size = rl_frame_size ? rl_frame_size * 2 : 1024;
+      rl_frame_buffer = (char *)xrealloc (rl_frame_buffer, rl_frame_size);
+    }
+  memcpy (rl_frame_buffer + rl_frame_len, string, count);
+  rl_frame_len += count;
+}
+
+/* Start collecting output for a redisplay.  Calls nest; only the outermost
+   _rl_frame_end writes the output. */
+void
+_rl_frame_begin (void)
+{
+  if (rl_frame_depth++ > 0)
+    return;
+
+  rl_frame_len = 0;
+  if (_rl_enable_synchronized_output)
+    rl_frame_append (SYNC_OUTPUT_BEGIN, sizeof (SYNC_OUTPUT_BEGIN) - 1);
+  rl_frame_start = rl_frame_len;
+  rl_redisplay_output_bytes = rl_redisplay_output_writes = 0;
+}
+
+/* Write the output collected so far in the current redisplay, if any. */
+void
+_rl_frame_flush (void)
+{
+  char *p;
+  size_t n;
+  ssize_t r;
+  int fd;
+
+  if (rl_frame_depth == 0 || rl_frame_len == rl_frame_start)
+    return;
+
+  if (_rl_enable_synchronized_output)
+    rl_frame_append (SYNC_OUTPUT_END, sizeof (SYNC_OUTPUT_END) - 1);
+
+  /* A line-buffered stream would split the frame at each newline, so
+     write it directly to the file descriptor after anything already in
+     the stream's buffer. */
+  fflush (_rl_out_stream);
+  fd = fileno (_rl_out_stream);
+  if (fd >= 0)
+    {
+      for (p = rl_frame_buffer, n = rl_frame_len; n > 0; p += r, n -= r)
+	if ((r = write (fd, p, n)) < 0)
+	  {
+	    if (errno != EINTR)
+	      break;
+	    r = 0;
+	  }
+    }
+  else
+    {
+      fwrite (rl_frame_buffer, 1, rl_frame_len, _rl_out_stream);
+      fflush (_rl_out_stream);
+    }
+  rl_redisplay_output_bytes += rl_frame_len;
+  rl_redisplay_output_writes++;
+
+  rl_frame_len = 0;
+  if (_rl_enable_synchronized_output)
+    rl_frame_append (SYNC_OUTPUT_BEGIN, sizeof (SYNC_OUTPUT_BEGIN) - 1);
+  rl_frame_start = rl_frame_len;
+}
+
+void
+_rl_frame_end (void)
+{
+  if (rl_frame_depth == 0)
+    return;
+  if (rl_frame_depth == 1)
+    _rl_frame_flush ();
+  rl_frame_depth--;
+}
+
 /* A function for the use of tputs () */
 #ifdef _MINIX
 void
 _rl_output_character_function (int c)
 {
-  putc (c, _rl_out_stream);
+  char ch;
+
+  if (rl_frame_depth)
+    {
+      ch = c;
+      rl_frame_append (&ch, 1);
+    }
+  else
+    putc (c, _rl_out_stream);
 }
 #else /* !_MINIX */
 int
 _rl_output_character_function (int c)
 {
+  char ch;
+
+  if (rl_frame_depth)
+    {
+      ch = c;
+      rl_frame_append (&ch, 1);
+      return ((unsigned char)c);
+    }
   return putc (c, _rl_out_stream);
 }
 #endif /* !_MINIX */
@@ -821,7 +943,10 @@ _rl_output_character_function (int c)
 void
 _rl_output_some_chars (const char *string, int count)
 {
-  fwrite (string, 1, count, _rl_out_stream);
+  if (rl_frame_depth)
+    rl_frame_append (string, count);
+  else
+    fwrite (string, 1, count, _rl_out_stream);
 }
 
 /* Move the cursor back. */
@@ -837,7 +962,7 @@ _rl_backspace (int count)
   else
 #endif
     for (i = 0; i < count; i++)
-      putc ('\b', _rl_out_stream);
+      _rl_output_character_function ('\b');
   return 0;
 }
 
@@ -849,7 +974,7 @@ rl_crlf (void)
   if (_rl_term_cr)
     tputs (_rl_term_cr, 1, _rl_output_character_function);
 #endif /* NEW_TTY_DRIVER || __MINT__ */
-  putc ('\n', _rl_out_stream);
+  _rl_output_character_function ('\n');
   return 0;
 }
 
@@ -857,7 +982,7 @@ void
 _rl_cr (void)
 {
 #if defined (__MSDOS__)
-  putc ('\r', rl_outstream);
+  _rl_output_character_function ('\r');
 #else
   tputs (_rl_term_cr, 1, _rl_output_character_function);
 #endif
@@ -599,9 +599,12 @@ rl_clear_screen (int count, int key)
       return 0;
     }
 
+  /* Clear the screen and redraw the line in a single write */
+  _rl_frame_begin ();
   _rl_clear_screen (0);		/* calls termcap function to clear screen */
   rl_keep_mark_active ();
   rl_forced_update_display ();
+  _rl_frame_end ();
   rl_display_fixed = 1;
 
   return 0;
@@ -610,8 +613,10 @@ rl_clear_screen (int count, int key)
 int
 rl_clear_display (int count, int key)
 {
+  _rl_frame_begin ();
   _rl_clear_screen (1);		/* calls termcap function to clear screen and scrollback buffer */
   rl_forced_update_display ();
+  _rl_frame_end ();
   rl_display_fixed = 1;
 
   return 0;
@@ -42,6 +42,10 @@
 #include <stdio.h>
 #include <ctype.h>
 
+#if defined (HAVE_LOCALE_H)
+#  include <locale.h>
+#endif
+
 /* System-specific feature definitions and include files. */
 #include "rlmbutil.h"
 #include "rldefs.h"
@@ -57,6 +61,8 @@
 #include "xmalloc.h"
 #include "rlshell.h"
 
+typedef int QSFUNC (const void *, const void *);
+
 /* **************************************************************** */
 /*								    */
 /*			Utility Functions			    */
@@ -430,6 +436,151 @@ _rl_qsort_string_compare (char **s1, char **s2)
 #endif
 }
 
+/* Sort the LEN strings in ARRAY the way qsort with _rl_qsort_string_compare
+   would, but transform each string with strxfrm(3) once instead of calling
+   strcoll(3) for every comparison.  That's a large win for long completion
+   lists in locales with expensive collation. */
+
+struct _rl_sortkey
+{
+  char *key;
+  char *str;
+};
+
+static int
+_rl_sortkey_compare (struct _rl_sortkey *k1, struct _rl_sortkey *k2)
+{
+  return (strcmp (k1->key, k2->key));
+}
+
+void
+_rl_sort_strings (char **array, size_t len)
+{
+#if defined (HAVE_STRCOLL)
+  struct _rl_sortkey *keys;
+  char *xbuf;
+  size_t *offsets, bsize, bind, avail, n, i;
+#  if defined (HAVE_SETLOCALE) && defined (LC_COLLATE)
+  char *l;
+
+  l = setlocale (LC_COLLATE, (char *)NULL);
+  if (l == 0 || STREQ (l, "C") || STREQ (l, "POSIX"))
+    {
+      qsort (array, len, sizeof (char *), (QSFUNC *)_rl_qsort_string_compare);
+      return;
+    }
+#  endif
+
+  /* Not worth it for short lists */
+  if (len < 32)
+    {
+      qsort (array, len, sizeof (char *), (QSFUNC *)_rl_qsort_string_compare);
+      return;
+    }
+
+  keys = (struct _rl_sortkey *)xmalloc (len * sizeof (struct _rl_sortkey));
+  offsets = (size_t *)xmalloc (len * sizeof (size_t));
+  bsize = len * 32;
+  xbuf = (char *)xmalloc (bsize);
+
+  for (i = bind = 0; i < len; i++)
+    {
+      avail = bsize - bind;
+      n = strxfrm (xbuf + bind, array[i], avail);
+      if (n >= avail)
+	{
+	  bsize += n + 1 + (bsize >> 1);
+	  xbuf = (char *)xrealloc (xbuf, bsize);
+	  strxfrm (xbuf + bind, array[i], bsize - bind);
+	}
+      offsets[i] = bind;
+      bind += n + 1;
+    }
+  for (i = 0; i < len; i++)
+    {
+      keys[i].key = xbuf + offsets[i];
+      keys[i].str = array[i];
+    }
+  xfree (offsets);
+
+  qsort (keys, len, sizeof (struct _rl_sortkey), (QSFUNC *)_rl_sortkey_compare);
+
+  for (i = 0; i < len; i++)
+    array[i] = keys[i].str;
+
+  xfree (xbuf);
+  xfree (keys);
+#else
+  qsort (array, len, sizeof (char *), (QSFUNC *)_rl_qsort_string_compare);
+#endif
+}
+
+/* Rearrange the LEN strings in ARRAY so the K that sort first are at the
+   front, in sorted order; the order of the rest is unspecified.  This is
+   quickselect followed by sorting the first K, so displaying the first
+   screenful of a long list of completions doesn't require sorting all
+   of it. */
+void
+_rl_sort_strings_prefix (char **array, size_t len, size_t k)
+{
+  size_t lo, hi, i, j, mid;
+  char *pivot, *t;
+
+  if (k >= len)
+    {
+      _rl_sort_strings (array, len);
+      return;
+    }
+  if (k == 0)
+    return;
+
+#define SWAPSTR(a, b)	do { t = (a); (a) = (b); (b) = t; } while (0)
+#define STRCMP(a, b)	_rl_qsort_string_compare (&(a), &(b))
+
+  /* Partition until array[k-1] is in its final place with everything that
+     sorts before it to its left. */
+  lo = 0;
+  hi = len - 1;
+  while (lo < hi)
+    {
+      /* Median of three, which leaves array[lo] <= array[mid] <= array[hi]. */
+      mid = lo + (hi - lo) / 2;
+      if (STRCMP (array[mid], array[lo]) < 0)
+	SWAPSTR (array[mid], array[lo]);
+      if (STRCMP (array[hi], array[lo]) < 0)
+	SWAPSTR (array[hi], array[lo]);
+      if (STRCMP (array[hi], array[mid]) < 0)
+	SWAPSTR (array[hi], array[mid]);
+      if (hi - lo < 3)
+	break;
+
+      pivot = array[mid];
+      i = lo;
+      j = hi;
+      for (;;)
+	{
+	  while (STRCMP (array[++i], pivot) < 0)
+	    ;
+	  while (STRCMP (pivot, array[--j]) < 0)
+	    ;
+	  if (i >= j)
+	    break;
+	  SWAPSTR (array[i], array[j]);
+	}
+
+      /* array[lo..j] <= pivot <= array[j+1..hi] */
+      if (k - 1 <= j)
+	hi = j;
+      else
+	lo = j + 1;
+    }
+
+#undef SWAPSTR
+#undef STRCMP
+
+  _rl_sort_strings (array, k);
+}
+
 /* Function equivalents for the macros defined in chardefs.h. */
 #define FUNCTION_FOR_MACRO(f)	int (f) (int c) { return f (c); }
 
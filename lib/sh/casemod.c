@@ -69,6 +69,8 @@
 
 extern char *substring (char *, size_t, size_t);
 
+extern int locale_asciicase;
+
 #ifndef UCHAR_MAX
 #  define UCHAR_MAX	TYPE_MAXIMUM(unsigned char)
 #endif
@@ -124,6 +126,13 @@ sh_modcase (const char *string, char *pat, int flags)
   start = 0;
   end = strlen (string);
   mb_cur_max = MB_CUR_MAX;
+#if defined (HANDLE_MULTIBYTE)
+  /* Strings of 7-bit characters can be converted a byte at a time unless
+     the locale maps some ASCII letters to multibyte characters. */
+  if (mb_cur_max > 1 && locale_asciicase && locale_shiftstates == 0 &&
+	mbsasciispan (string) == end)
+    mb_cur_max = 1;
+#endif
 
   ret = (char *)xmalloc (2*end + 1);
   retind = 0;
@@ -17,8 +17,10 @@
 #include <config.h>
 
 #if defined (HANDLE_MULTIBYTE)
+#include <bashtypes.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <bashansi.h>
 
 #include <errno.h>
 
@@ -49,6 +51,54 @@ extern int locale_utf8locale;
 
 extern char *utf8_mbsmbchar (const char *);
 extern int utf8_mblen (const char *, size_t);
+extern size_t utf8_mbstrlen (const char *);
+
+/* Word-at-a-time tests for scanning runs of 7-bit characters.  A word has a
+   byte with the eighth bit set if W & ASCII_HIGHBITS is non-zero, and has a
+   NUL byte if ASCII_HASZERO(W) is non-zero. */
+#define ASCII_ONES	((unsigned long)-1 / 0xff)
+#define ASCII_HIGHBITS	(ASCII_ONES << 7)
+#define ASCII_HASZERO(w)	(((w) - ASCII_ONES) & ~(w) & ASCII_HIGHBITS)
+
+/* mbsasciispan reads whole aligned words, which can include bytes past the
+   terminating NUL that belong to no object.  That can't fault, but address
+   sanitizers report it, so turn them off for that function. */
+#if defined (__has_attribute)
+#  if __has_attribute (no_sanitize_address)
+#    define NO_SANITIZE_ADDRESS __attribute__ ((no_sanitize_address))
+#  endif
+#endif
+#if !defined (NO_SANITIZE_ADDRESS)
+#  define NO_SANITIZE_ADDRESS
+#endif
+
+/* Return the length of the initial segment of S consisting of non-null 7-bit
+   characters.  S[mbsasciispan(S)] is NUL if and only if S is all ASCII.
+   Once S is aligned this checks a word at a time; an aligned word never
+   crosses a page boundary, so reading past the terminating NUL is safe.
+   The words are loaded with memcpy, which compiles to a single load, so
+   the string isn't accessed through an incompatible pointer type. */
+NO_SANITIZE_ADDRESS size_t
+mbsasciispan (const char *s)
+{
+  const unsigned char *p;
+  unsigned long v;
+
+  for (p = (const unsigned char *)s; ((uintptr_t)p & (sizeof (unsigned long) - 1)) != 0; p++)
+    if (*p == 0 || *p >= 0x80)
+      return (p - (const unsigned char *)s);
+
+  for ( ; ; p += sizeof (unsigned long))
+    {
+      memcpy (&v, p, sizeof (v));
+      if ((v | ASCII_HASZERO (v)) & ASCII_HIGHBITS)
+	break;
+    }
+
+  for ( ; *p && *p < 0x80; p++)
+    ;
+  return (p - (const unsigned char *)s);
+}
 
 /* Count the number of characters in S, counting multi-byte characters as a
    single character. */
@@ -59,6 +109,9 @@ mbstrlen (const char *s)
   mbstate_t mbs = { 0 }, mbsbak = { 0 };
   int f, mb_cur_max;
 
+  if (locale_utf8locale)
+    return (utf8_mbstrlen (s));
+
   nc = 0;
   mb_cur_max = MB_CUR_MAX;
   while (*s && (clen = (f = is_basic (*s)) ? 1 : mbrlen(s, mb_cur_max, &mbs)) != 0)
@@ -32,6 +32,7 @@
 #include <chartypes.h>
 
 #include "shell.h"
+#include "bashintl.h"
 
 /* Allocate an array of strings with room for N members. */
 char **
@@ -182,14 +183,253 @@ strvec_strcmp (char **s1, char **s2)
 #endif /* !HAVE_STRCOLL */
 }
 
-/* Sort ARRAY, a null terminated array of pointers to strings. */
+/* Sorting large arrays of strings with qsort and strcoll(3) calls strcoll
+   O(n log n) times, and strcoll is expensive in most multibyte locales.
+   Instead, we compute a sort key for each string once -- the string itself
+   if the locale collates bytewise, its strxfrm(3) transformation otherwise --
+   and sort the keys with a multikey (three-way radix) quicksort, which looks
+   at each key byte a small number of times. */
+
+typedef struct strvec_sortkey {
+  const char *key;
+  void *item;
+} STRVEC_SORTKEY;
+
+/* Arrays shorter than this are sorted with the comparison functions above;
+   transforming the strings doesn't pay for itself. */
+#define STRVEC_XFRM_MIN		32
+
+/* Partitions smaller than this are finished with an insertion sort. */
+#define SK_INSERTION_MAX	12
+
+#define SK_CHAR(a, i, d)	((unsigned char)(a)[i].key[d])
+
+static inline void
+sk_swap (STRVEC_SORTKEY *a, size_t i, size_t j)
+{
+  STRVEC_SORTKEY t;
+
+  t = a[i];
+  a[i] = a[j];
+  a[j] = t;
+}
+
+/* Compare two keys that are known to be equal in the first DEPTH bytes.  If
+   the keys are identical and FLAGS includes STRVEC_POSIX, break the tie with
+   a bytewise comparison of the original strings. */
+static inline int
+sk_compare (STRVEC_SORTKEY *k1, STRVEC_SORTKEY *k2, size_t depth, int flags)
+{
+  int r;
+
+  r = strcmp (k1->key + depth, k2->key + depth);
+  if (r == 0 && (flags & STRVEC_POSIX))
+    r = strcmp ((char *)k1->item, (char *)k2->item);
+  return r;
+}
+
+static void
+sk_insertion (STRVEC_SORTKEY *a, size_t n, size_t depth, int flags)
+{
+  size_t i, j;
+
+  for (i = 1; i < n; i++)
+    for (j = i; j > 0 && sk_compare (&a[j-1], &a[j], depth, flags) > 0; j--)
+      sk_swap (a, j - 1, j);
+}
+
+/* Sort the N keys in A, all of which are equal in the first DEPTH bytes. */
+static void
+sk_mkqsort (STRVEC_SORTKEY *a, size_t n, size_t depth, int flags)
+{
+  size_t lt, gt, i, m;
+  int c, v;
+
+  while (n > SK_INSERTION_MAX)
+    {
+      /* median of three for the pivot byte */
+      m = n / 2;
+      if (SK_CHAR (a, m, depth) < SK_CHAR (a, 0, depth))
+	sk_swap (a, 0, m);
+      if (SK_CHAR (a, n - 1, depth) < SK_CHAR (a, 0, depth))
+	sk_swap (a, 0, n - 1);
+      if (SK_CHAR (a, n - 1, depth) < SK_CHAR (a, m, depth))
+	sk_swap (a, m, n - 1);
+      sk_swap (a, 0, m);
+      v = SK_CHAR (a, 0, depth);
+
+      /* a[0..lt) < v, a[lt..gt) == v, a[gt..n) > v */
+      lt = 0;
+      gt = n;
+      i = 1;
+      while (i < gt)
+	{
+	  c = SK_CHAR (a, i, depth);
+	  if (c < v)
+	    sk_swap (a, lt++, i++);
+	  else if (c > v)
+	    sk_swap (a, i, --gt);
+	  else
+	    i++;
+	}
+
+      sk_mkqsort (a, lt, depth, flags);
+      if (v != 0)
+	sk_mkqsort (a + lt, gt - lt, depth + 1, flags);
+      else if ((flags & STRVEC_POSIX) && gt - lt > 1)
+	sk_insertion (a + lt, gt - lt, depth, flags);	/* identical keys */
+
+      a += gt;
+      n -= gt;
+    }
+
+  if (n > 1)
+    sk_insertion (a, n, depth, flags);
+}
+
+/* Return non-zero if the current locale collates strings in byte order, so
+   strcoll(3) is equivalent to strcmp(3). */
+static int
+strvec_bytecollate (void)
+{
+#if defined (HAVE_STRCOLL)
+#  if defined (HAVE_SETLOCALE) && defined (LC_COLLATE)
+  char *l;
+
+  l = setlocale (LC_COLLATE, (char *)NULL);
+  return (l == 0 || STREQ (l, "C") || STREQ (l, "POSIX"));
+#  else
+  return 0;
+#  endif
+#else
+  return 1;
+#endif
+}
+
+#if defined (HAVE_STRCOLL)
+/* Set the key of each of the N elements of KEYS to the strxfrm(3)
+   transformation of its item.  The keys are stored contiguously in a
+   single buffer, which is returned and should be freed by the caller. */
+static char *
+strvec_xfrmkeys (STRVEC_SORTKEY *keys, size_t n)
+{
+  char *buf;
+  size_t *offsets, bsize, bind, avail, len, i;
+
+  offsets = (size_t *)xreallocarray (NULL, n, sizeof (size_t));
+  bsize = n * 32;
+  buf = (char *)xmalloc (bsize);
+
+  for (i = bind = 0; i < n; i++)
+    {
+      avail = bsize - bind;
+      len = strxfrm (buf + bind, (char *)keys[i].item, avail);
+      if (len >= avail)
+	{
+	  bsize += len + 1 + (bsize >> 1);
+	  buf = (char *)xrealloc (buf, bsize);
+	  strxfrm (buf + bind, (char *)keys[i].item, bsize - bind);
+	}
+      offsets[i] = bind;
+      bind += len + 1;
+    }
+
+  for (i = 0; i < n; i++)
+    keys[i].key = buf + offsets[i];
+
+  free (offsets);
+  return buf;
+}
+#endif
+
+/* Sort the N elements of ARRAY by the strings KEYFUNC returns for them.
+   If FLAGS includes STRVEC_COLLATE, the strings are sorted according to the
+   current locale's collation order; otherwise they are compared bytewise.
+   STRVEC_POSIX breaks ties between strings that collate equally with a
+   bytewise comparison, as strvec_posixcmp does.  A NULL KEYFUNC means the
+   elements of ARRAY are the strings themselves. */
+void
+strvec_keysort (void **array, size_t n, sh_strvec_key_func_t *keyfunc, int flags)
+{
+  STRVEC_SORTKEY *keys;
+  char *xbuf;
+  size_t i;
+
+  if (n < 2)
+    return;
+
+  if ((flags & STRVEC_COLLATE) && strvec_bytecollate ())
+    flags &= ~STRVEC_COLLATE;
+
+  keys = (STRVEC_SORTKEY *)xreallocarray (NULL, n, sizeof (STRVEC_SORTKEY));
+  for (i = 0; i < n; i++)
+    {
+      keys[i].item = array[i];
+      keys[i].key = keyfunc ? (*keyfunc) (array[i]) : (char *)array[i];
+    }
+
+  xbuf = 0;
+#if defined (HAVE_STRCOLL)
+  if (flags & STRVEC_COLLATE)
+    {
+      if (keyfunc)
+	for (i = 0; i < n; i++)
+	  keys[i].item = (void *)keys[i].key;
+      xbuf = strvec_xfrmkeys (keys, n);
+      if (keyfunc)
+	for (i = 0; i < n; i++)
+	  keys[i].item = array[i];
+    }
+#endif
+
+  /* The tie-breaker compares items as strings; it's only needed when the
+     keys are transformations of the strings. */
+  if (xbuf == 0 || keyfunc)
+    flags &= ~STRVEC_POSIX;
+
+  sk_mkqsort (keys, n, 0, flags);
+
+  for (i = 0; i < n; i++)
+    array[i] = keys[i].item;
+
+  FREE (xbuf);
+  free (keys);
+}
+
+/* Sort ARRAY, a null terminated array of pointers to strings, according to
+   the current locale.  If POSIX is non-zero, strings that collate equally are
+   sorted bytewise. */
 void
 strvec_sort (char **array, int posix)
 {
-  if (posix)
-    qsort (array, strvec_len (array), sizeof (char *), (QSFUNC *)strvec_posixcmp);
+  size_t len;
+
+  len = strvec_len (array);
+  if (len < STRVEC_XFRM_MIN && strvec_bytecollate () == 0)
+    {
+      if (posix)
+	qsort (array, len, sizeof (char *), (QSFUNC *)strvec_posixcmp);
+      else
+	qsort (array, len, sizeof (char *), (QSFUNC *)strvec_strcmp);
+    }
   else
-    qsort (array, strvec_len (array), sizeof (char *), (QSFUNC *)strvec_strcmp);
+    strvec_keysort ((void **)array, len, (sh_strvec_key_func_t *)NULL, STRVEC_COLLATE|(posix ? STRVEC_POSIX : 0));
+}
+
+/* Reverse the order of the elements of ARRAY, a null terminated array of
+   pointers to strings. */
+void
+strvec_reverse (char **array)
+{
+  size_t i, j;
+  char *t;
+
+  for (i = 0, j = strvec_len (array); i + 1 < j; i++, j--)
+    {
+      t = array[i];
+      array[i] = array[j - 1];
+      array[j - 1] = t;
+    }
 }
 
 /* Cons up a new array of words.  The words are taken from LIST,
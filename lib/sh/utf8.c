@@ -50,7 +50,7 @@ utf8_mbsmbchar (const char *str)
 {
   char *s;
 
-  for (s = (char *)str; *s; s++)
+  for (s = (char *)str + mbsasciispan (str); *s; s++)
     if ((*s & 0xc0) == 0x80)
       return s;
   return (0);
@@ -172,8 +172,18 @@ utf8_mbstrlen (const char *s)
 
   nc = 0;
   mb_cur_max = MB_CUR_MAX;
-  while (*s && (clen = (size_t)utf8_mblen(s, mb_cur_max)) != 0)
+  while (*s)
     {
+      /* Runs of 7-bit characters are one character per byte. */
+      if (UTF8_SINGLEBYTE (*s))
+	{
+	  clen = mbsasciispan (s);
+	  s += clen;
+	  nc += clen;
+	  continue;
+	}
+
+      clen = (size_t)utf8_mblen(s, mb_cur_max);
       if (MB_INVALIDCH(clen))
 	clen = 1;	/* assume single byte */
 
@@ -183,4 +193,32 @@ utf8_mbstrlen (const char *s)
   return nc;
 }
 
+/* Return the byte offset of the character N characters past byte offset
+   IND in S, which is SLEN bytes long, stopping at the end of S.  Invalid
+   or incomplete sequences count as single characters, like ADVANCE_CHAR. */
+size_t
+utf8_mbsadvance (const char *s, size_t slen, size_t ind, size_t n)
+{
+  size_t span;
+  int clen;
+
+  while (n && s[ind])
+    {
+      if (UTF8_SINGLEBYTE (s[ind]))
+	{
+	  span = mbsasciispan (s + ind);
+	  if (span > n)
+	    span = n;
+	  ind += span;
+	  n -= span;
+	  continue;
+	}
+
+      clen = utf8_mblen (s + ind, slen - ind);
+      ind += (clen > 0) ? clen : 1;
+      n--;
+    }
+  return ind;
+}
+
 #endif
@@ -38,6 +38,7 @@
 
 #include "shell.h"
 #include "input.h"	/* For bash_input */
+#include "shmbutil.h"
 
 #ifndef errno
 extern int errno;
@@ -54,6 +55,7 @@ extern int dump_translatable_strings, dump_po_strings;
 int locale_utf8locale;
 int locale_mb_cur_max;	/* value of MB_CUR_MAX for current locale (LC_CTYPE) */
 int locale_shiftstates = 0;
+int locale_asciicase = 1;	/* ASCII letters have ASCII case equivalents */
 
 int singlequote_translations = 0;	/* single-quote output of $"..." */
 
@@ -78,6 +80,7 @@ static int reset_locale_vars (void);
 
 static void locale_setblanks (void);
 static int locale_isutf8 (char *);
+static int locale_isasciicase (void);
 
 /* Set the value of default_locale and make the current locale the
    system default locale.  This should be called very early in main(). */
@@ -101,6 +104,7 @@ set_default_locale (void)
 #else
   locale_shiftstates = 0;
 #endif
+  locale_asciicase = locale_isasciicase ();
 }
 
 /* Set default values for LC_CTYPE, LC_COLLATE, LC_MESSAGES, LC_NUMERIC and
@@ -128,6 +132,7 @@ set_default_locale_vars (void)
       locale_shiftstates = 0;
 #    endif
 
+      locale_asciicase = locale_isasciicase ();
       u32reset ();
     }
 #  endif
@@ -237,6 +242,7 @@ set_locale_var (const char *var, const char *value)
 #  else
       locale_shiftstates = 0;
 #  endif
+      locale_asciicase = locale_isasciicase ();
       u32reset ();
       return r;
 #else
@@ -261,6 +267,7 @@ set_locale_var (const char *var, const char *value)
 #else
 	  locale_shiftstates = 0;
 #endif
+	  locale_asciicase = locale_isasciicase ();
 	  u32reset ();
 	}
 #  endif
@@ -413,6 +420,7 @@ reset_locale_vars (void)
 #  else
   locale_shiftstates = 0;
 #  endif
+  locale_asciicase = locale_isasciicase ();
   u32reset ();
 #endif
   return retval;
@@ -610,6 +618,25 @@ locale_setblanks (void)
     }
 }
 
+/* Return 1 if every ASCII character has the same upper and lower case
+   equivalents as a wide character as it does as a single byte, so strings
+   of 7-bit characters can have their case changed a byte at a time.  Some
+   locales (e.g., Turkish) map ASCII letters to multibyte characters. */
+static int
+locale_isasciicase (void)
+{
+#if defined (HANDLE_MULTIBYTE)
+  int c;
+
+  if (locale_mb_cur_max == 1)
+    return 1;
+  for (c = 1; c < 0x80; c++)
+    if (towupper (c) != TOUPPER (c) || towlower (c) != TOLOWER (c))
+      return 0;
+#endif
+  return 1;
+}
+
 /* Parse a locale specification
      language[_territory][.codeset][@modifier][+special][,[sponsor][_revision]]
    and return TRUE if the codeset is UTF-8 or utf8 */
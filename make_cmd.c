@@ -61,6 +61,9 @@ static WORD_LIST *make_arith_for_expr (char *);
 #endif
 static COMMAND *make_until_or_while (enum command_type, COMMAND *, COMMAND *);
 
+static int case_literal_pattern (WORD_DESC *);
+static CASE_DISPATCH *make_case_dispatch (PATTERN_LIST *);
+
 void
 cmd_init (void)
 {
@@ -321,6 +324,92 @@ make_group_command (COMMAND *command)
   return (make_command (cm_group, (SIMPLE_COM *)temp));
 }
 
+/* Don't bother with a case command lookup table unless there are at least
+   this many literal patterns. */
+#define CASE_DISPATCH_MIN	4
+
+#define CASE_DISPATCH_BUCKETS	16	/* must be power of two; grows as needed */
+
+/* Characters that can appear in a literal pattern: no quoting, expansions,
+   pattern matching characters, or tilde, and no multibyte characters. */
+#define CASE_LITERAL_CHAR(c) \
+  (((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z') || \
+   ((c) >= '0' && (c) <= '9') || (c) == '_' || (c) == '-' || (c) == '.' || \
+   (c) == '/' || (c) == ':' || (c) == ',' || (c) == '=' || (c) == '%')
+
+/* Return non-zero if the case pattern PAT matches only itself. */
+static int
+case_literal_pattern (WORD_DESC *pat)
+{
+  char *s;
+
+  for (s = pat->word; *s; s++)
+    if (CASE_LITERAL_CHAR (*s) == 0)
+      return 0;
+  return (s != pat->word);
+}
+
+/* Build a lookup table for a case command with CLAUSES, so a dispatcher
+   on many literal strings doesn't have to expand and match each pattern in
+   order.  Returns NULL if there aren't enough literal patterns. */
+static CASE_DISPATCH *
+make_case_dispatch (PATTERN_LIST *clauses)
+{
+  CASE_DISPATCH *d;
+  PATTERN_LIST *p;
+  WORD_LIST *list;
+  BUCKET_CONTENTS *b;
+  int *ind, i, nclauses, nliterals, ncomplex, literal;
+
+  for (nliterals = nclauses = 0, p = clauses; p; p = p->next, nclauses++)
+    for (list = p->patterns; list; list = list->next)
+      nliterals += case_literal_pattern (list->word);
+
+  if (nliterals < CASE_DISPATCH_MIN)
+    return ((CASE_DISPATCH *)NULL);
+
+  d = (CASE_DISPATCH *)xmalloc (sizeof (CASE_DISPATCH));
+  d->refcount = 1;
+  d->nclauses = nclauses;
+  d->literals = hash_create (CASE_DISPATCH_BUCKETS);
+  d->complex = (int *)xmalloc ((nclauses + 1) * sizeof (int));
+
+  for (i = ncomplex = 0, p = clauses; p; p = p->next, i++)
+    {
+      literal = 1;
+      for (list = p->patterns; list; list = list->next)
+	{
+	  if (case_literal_pattern (list->word) == 0)
+	    {
+	      literal = 0;
+	      continue;
+	    }
+	  /* The data is an array of clause indices; element 0 is the count */
+	  b = hash_search (list->word->word, d->literals, HASH_CREATE);
+	  if (b->data == 0)
+	    {
+	      b->key = savestring (list->word->word);
+	      ind = (int *)xmalloc (2 * sizeof (int));
+	      ind[0] = 0;
+	    }
+	  else
+	    {
+	      ind = (int *)b->data;
+	      if (ind[ind[0]] == i)
+		continue;	/* same pattern twice in one clause */
+	      ind = (int *)xrealloc (ind, (ind[0] + 2) * sizeof (int));
+	    }
+	  ind[++ind[0]] = i;
+	  b->data = ind;
+	}
+      if (literal == 0)
+	d->complex[ncomplex++] = i;
+    }
+  d->complex[ncomplex] = -1;
+
+  return d;
+}
+
 COMMAND *
 make_case_command (WORD_DESC *word, PATTERN_LIST *clauses, int lineno)
 {
@@ -331,6 +420,7 @@ make_case_command (WORD_DESC *word, PATTERN_LIST *clauses, int lineno)
   temp->line = lineno;
   temp->word = word;
   temp->clauses = REVERSE_LIST (clauses, PATTERN_LIST *);
+  temp->dispatch = make_case_dispatch (temp->clauses);
   return (make_command (cm_case, (SIMPLE_COM *)temp));
 }
 
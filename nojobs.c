@@ -45,6 +45,7 @@
 #include "jobs.h"
 #include "execute_cmd.h"
 #include "trap.h"
+#include "profile.h"
 
 #include "builtins/builtext.h"	/* for wait_builtin */
 #include "builtins/common.h"
@@ -492,6 +493,8 @@ make_child (char *command, int flags)
   if (default_buffered_input != -1 && (!async_p || default_buffered_input > 0))
     sync_buffered_stream (default_buffered_input);
 
+  xtrace_flush ();
+
   /* Block SIGTERM here and unblock in child after fork resets the
      set of pending signals */
   if (interactive_shell)
@@ -508,6 +511,7 @@ make_child (char *command, int flags)
   while ((pid = fork ()) < 0 && errno == EAGAIN && forksleep < FORKSLEEP_MAX)
     {
       sys_error ("fork: retry");
+      shell_stats.fork_retries++;
 
 #if defined (HAVE_WAITPID)
       /* Posix systems with a non-blocking waitpid () system call available
@@ -532,6 +536,7 @@ make_child (char *command, int flags)
   if (pid < 0)
     {
       sys_error ("fork");
+      shell_stats.fork_failures++;
       last_command_exit_value = EX_NOEXEC;
       throw_to_top_level ();
     }
@@ -553,11 +558,15 @@ make_child (char *command, int flags)
 
       subshell_environment |= SUBSHELL_IGNTRAP;
 
+      /* Only the process that started the profiler reports. */
+      profiling_enabled = 0;
+
       default_tty_job_signals ();
     }
   else
     {
       /* In the parent. */
+      shell_stats.forks++;
 
       last_made_pid = pid;
 
@@ -35,6 +35,7 @@
 #include "shell.h"
 #include "pathexp.h"
 #include "flags.h"
+#include "profile.h"
 
 #include "shmbutil.h"
 #include "bashintl.h"
@@ -445,6 +446,7 @@ shell_glob_filename (const char *pathname, int qflags)
   int gflags, quoted_pattern;
 
   noglob_dot_filenames = glob_dot_filenames == 0;
+  shell_stats.globs++;
 
   temp = quote_string_for_globbing (pathname, QGLOB_FILENAME|qflags);
   gflags = glob_star ? GX_GLOBSTAR : 0;
@@ -875,10 +877,14 @@ globsort_buildarray (char **array, size_t len)
   return ret;
 }  
           
+/* Sort by name using precomputed collation keys rather than calling
+   globsort_namecmp (and strcoll) O(n log n) times. */
 static inline void
 globsort_sortbyname (char **results)
 {
-  qsort (results, strvec_len (results), sizeof (char *), (QSFUNC *)globsort_namecmp);
+  strvec_sort (results, 1);
+  if (glob_sorttype >= SORT_REVERSE)
+    strvec_reverse (results);
 }
 
 static void
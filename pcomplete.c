@@ -35,23 +35,26 @@
 
 #include "posixtime.h"
 
+#define NEED_FPURGE_DECL
+
 #include <stdio.h>
+#include <errno.h>
 #include "bashansi.h"
 #include "bashintl.h"
 
 #include "shell.h"
+#include "flags.h"
 #include "pcomplete.h"
 #include "alias.h"
 #include "bashline.h"
 #include "execute_cmd.h"
 #include "pathexp.h"
 
-#if defined (JOB_CONTROL)
-#  include "jobs.h"
-#endif
+#include "jobs.h"
+#include "trap.h"
 
-#if !defined (NSIG)
-#  include "trap.h"
+#if defined (HAVE_SELECT)
+#  include "posixselect.h"
 #endif
 
 #include "shmbutil.h"
@@ -131,6 +134,13 @@ static STRINGLIST *gen_progcomp_completions (const char *, const char *,
 
 static char *pcomp_filename_completion_function (const char *, int);
 
+typedef void PCOMP_ASYNC_FUNC (void *, int);
+
+static int pcomp_async_p (COMPSPEC *);
+static char *pcomp_async_run (PCOMP_ASYNC_FUNC *, void *, size_t *);
+static void pcomp_async_function (void *, int);
+static void pcomp_async_command (void *, int);
+
 #if defined (ARRAY_VARS)
 static SHELL_VAR *bind_comp_words (WORD_LIST *);
 #endif
@@ -857,47 +867,196 @@ gen_globpat_matches (COMPSPEC *cs, const char *text)
   return sl;
 }
 
+/* Return non-zero if expanding the -W word list WORDS can't depend on the
+   shell's state, beyond the $IFS used to split it and whether brace
+   expansion is enabled: no parameter, command, arithmetic, tilde, or
+   process substitution.  Quote removal is fine. */
+static int
+wordlist_static (const char *words)
+{
+  return (strpbrk (words, "$`~<>") == 0);
+}
+
+#if defined (BRACE_EXPANSION)
+#  define WORDLIST_BRACEEXP	brace_expansion
+#else
+#  define WORDLIST_BRACEEXP	0
+#endif
+
+static char **sorted_words;
+
+static int
+wordindex_compare (const void *a, const void *b)
+{
+  size_t i, j;
+
+  i = *(const size_t *)a;
+  j = *(const size_t *)b;
+  return ((i < j) ? -1 : (i > j));
+}
+
+static int
+wordvalue_compare (const void *a, const void *b)
+{
+  int r;
+
+  r = strcmp (sorted_words[*(const size_t *)a], sorted_words[*(const size_t *)b]);
+  return (r ? r : wordindex_compare (a, b));
+}
+
+/* Sort indices into CW's word list by value, so prefix matches can be
+   found with a binary search. */
+static void
+compwords_sort (COMPWORDS *cw)
+{
+  size_t i, n;
+
+  n = cw->words->list_len;
+  cw->sorted = (size_t *)xmalloc ((n + 1) * sizeof (size_t));
+  for (i = 0; i < n; i++)
+    cw->sorted[i] = i;
+  sorted_words = cw->words->list;
+  qsort (cw->sorted, n, sizeof (size_t), wordvalue_compare);
+  sorted_words = (char **)NULL;
+}
+
+/* Return the index in CW->sorted of the first word that compares greater
+   than or equal to (UPPER == 0) or greater than (UPPER != 0) TEXT, looking
+   only at the first TLEN characters. */
+static size_t
+compwords_bound (COMPWORDS *cw, const char *text, size_t tlen, int upper)
+{
+  size_t lo, hi, mid;
+  int r;
+
+  lo = 0;
+  hi = cw->words->list_len;
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      r = strncmp (cw->words->list[cw->sorted[mid]], text, tlen);
+      if (r < 0 || (upper && r == 0))
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  return lo;
+}
+
+/* Return non-zero if the words in L are the same as the ones in SL. */
+static int
+wordlist_unchanged (WORD_LIST *l, STRINGLIST *sl)
+{
+  size_t i;
+
+  for (i = 0; l && i < sl->list_len; l = l->next, i++)
+    if (STREQ (l->word->word, sl->list[i]) == 0)
+      return 0;
+  return (l == 0 && i == sl->list_len);
+}
+
 /* Perform the shell word expansions on CS->words and return the results.
    Again, this ignores TEXT. */
 static STRINGLIST *
 gen_wordlist_matches (COMPSPEC *cs, const char *text)
 {
   WORD_LIST *l, *l2;
-  STRINGLIST *sl;
-  size_t nw, tlen;
+  STRINGLIST *sl, *words;
+  COMPWORDS *cw;
+  size_t nw, tlen, i, lo, hi, *ind;
   char *ntxt;		/* dequoted TEXT to use in comparisons */
+  char *ifs;
 
   if (cs->words == 0 || cs->words[0] == '\0')
     return ((STRINGLIST *)NULL);
 
-  /* This used to be a simple expand_string(cs->words, 0), but that won't
-     do -- there's no way to split a simple list into individual words
-     that way, since the shell semantics say that word splitting is done
-     only on the results of expansion.  split_at_delims also handles embedded
-     quoted strings and preserves the quotes for the expand_words_shellexp
-     function call that follows. */
-  /* XXX - this is where this function spends most of its time */
-  l = split_at_delims (cs->words, strlen (cs->words), (char *)NULL, -1, 0, (int *)NULL, (int *)NULL);
-  if (l == 0)
-    return ((STRINGLIST *)NULL);
-  /* This will jump back to the top level if the expansion fails... */
-  l2 = expand_words_shellexp (l);
-  dispose_words (l);
+  /* The split and expanded list is kept in the compspec's cache.  A static
+     list is reused as long as $IFS and set -B don't change; a list with
+     expansions has to be expanded every time, but its sorted index can be
+     reused if the expansion gives the same words as last time. */
+  cw = cs->wordcache;
+  words = (STRINGLIST *)NULL;
+  ifs = ifs_value ? ifs_value : "";
+  if (cw && cw->words && wordlist_static (cs->words) &&
+      cw->braceexp == WORDLIST_BRACEEXP && STREQ (cw->ifs, ifs))
+    {
+      if (cw->sorted == 0)
+	compwords_sort (cw);
+    }
+  else
+    {
+      /* This used to be a simple expand_string(cs->words, 0), but that won't
+	 do -- there's no way to split a simple list into individual words
+	 that way, since the shell semantics say that word splitting is done
+	 only on the results of expansion.  split_at_delims also handles
+	 embedded quoted strings and preserves the quotes for the
+	 expand_words_shellexp function call that follows. */
+      l = split_at_delims (cs->words, strlen (cs->words), (char *)NULL, -1, 0, (int *)NULL, (int *)NULL);
+      if (l == 0)
+	return ((STRINGLIST *)NULL);
+      /* This will jump back to the top level if the expansion fails... */
+      l2 = expand_words_shellexp (l);
+      dispose_words (l);
+
+      if (cw && cw->words && wordlist_unchanged (l2, cw->words))
+	{
+	  if (cw->sorted == 0)
+	    compwords_sort (cw);
+	  dispose_words (l2);
+	}
+      else
+	{
+	  nw = list_length ((GENERIC_LIST *)l2);
+	  words = strlist_create (nw + 1);
+	  for (nw = 0, l = l2; l; l = l->next)
+	    words->list[nw++] = savestring (l->word->word);
+	  words->list[words->list_len = nw] = (char *)NULL;
+	  dispose_words (l2);
+
+	  if (cw)
+	    {
+	      compwords_flush (cw);
+	      cw->ifs = savestring (ifs);
+	      cw->braceexp = WORDLIST_BRACEEXP;
+	      cw->words = words;
+	    }
+	}
+    }
 
-  nw = list_length ((GENERIC_LIST *)l2);
-  sl = strlist_create (nw + 1);
+  if (cw && cw->words)
+    words = cw->words;
 
   ntxt = bash_dequote_text (text);
   tlen = STRLEN (ntxt);
 
-  for (nw = 0, l = l2; l; l = l->next)
+  if (cw && cw->sorted && tlen > 0)
     {
-      if (tlen == 0 || STREQN (l->word->word, ntxt, tlen))
-	sl->list[nw++] = STRDUP (l->word->word);
+      /* Find the range of words starting with NTXT, then put them back in
+	 their original order. */
+      lo = compwords_bound (cw, ntxt, tlen, 0);
+      hi = compwords_bound (cw, ntxt, tlen, 1);
+      sl = strlist_create (hi - lo + 1);
+      ind = (size_t *)xmalloc ((hi - lo + 1) * sizeof (size_t));
+      for (i = lo; i < hi; i++)
+	ind[i - lo] = cw->sorted[i];
+      qsort (ind, hi - lo, sizeof (size_t), wordindex_compare);
+      for (nw = 0; nw < hi - lo; nw++)
+	sl->list[nw] = savestring (words->list[ind[nw]]);
+      free (ind);
+    }
+  else
+    {
+      sl = strlist_create (words->list_len + 1);
+      for (nw = i = 0; i < words->list_len; i++)
+	{
+	  if (tlen == 0 || STREQN (words->list[i], ntxt, tlen))
+	    sl->list[nw++] = savestring (words->list[i]);
+	}
     }
   sl->list[sl->list_len = nw] = (char *)NULL;
 
-  dispose_words (l2);
+  if (cw == 0)
+    strlist_dispose (words);
   FREE (ntxt);
   return sl;
 }
@@ -1042,6 +1201,306 @@ build_arg_list (const char *cmd, const char *cname, const char *text, WORD_LIST
    Since the shell function should return its list of matches in an array
    variable, this does nothing if arrays are not compiled into the shell. */
 
+/* Asynchronous completion.  A compspec with the `async' option runs its
+   completion function or command in a child process while the shell keeps
+   watching the terminal.  A keystroke, an interrupt, or COMP_TIMEOUT
+   seconds passing cancels the completion and kills the child (and anything
+   it started); otherwise the child sends its results back through a pipe
+   and the shell applies them.  Since the line can't change while the shell
+   waits, results are only ever applied to the line they were computed for. */
+
+/* What pcomp_async_function needs to run a completion function. */
+struct pcomp_async_fn
+{
+  SHELL_VAR *f;
+  WORD_LIST *cmdlist;
+  COMPSPEC *cs;
+};
+
+/* Return non-zero if completions for CS should be generated asynchronously:
+   CS asks for it and readline is completing a word for an interactive
+   shell, not for compgen. */
+static int
+pcomp_async_p (COMPSPEC *cs)
+{
+#if defined (HAVE_SELECT)
+  return ((cs->options & COPT_ASYNC) && compgen_compspec == 0 &&
+	  interactive_shell && interactive && no_line_editing == 0 &&
+	  RL_ISSTATE (RL_STATE_COMPLETING) && subshell_environment == 0);
+#else
+  return 0;
+#endif
+}
+
+/* Run FUNC (ARG, FD) in a child process and collect what it writes to FD
+   while watching readline's input.  Returns what the child wrote, with a
+   NUL appended and its length in *LENP, or NULL if the completion was
+   cancelled or the child couldn't be started.  The caller should have
+   called rl_clear_signals, so an interrupt reaches the shell's handler and
+   cancels the wait. */
+static char *
+pcomp_async_run (PCOMP_ASYNC_FUNC *func, void *arg, size_t *lenp)
+{
+#if defined (HAVE_SELECT)
+  pid_t pid, old_pid;
+#if defined (JOB_CONTROL)
+  pid_t old_pipeline_pgrp;
+#endif
+  int fildes[2], infd, nfds, result, cancel, rc;
+  char *buf, *t;
+  size_t blen, bsize;
+  ssize_t nr;
+  long secs, usecs;
+  struct timeval deadline, now, tv, *tvp;
+  fd_set readfds;
+
+  *lenp = 0;
+
+  /* An unset, invalid, or zero COMP_TIMEOUT means no timeout. */
+  tvp = (struct timeval *)NULL;
+  t = get_string_value ("COMP_TIMEOUT");
+  if (t && *t && uconvert (t, &secs, &usecs, (char **)NULL) && (secs > 0 || usecs > 0))
+    {
+      gettimeofday (&deadline, 0);
+      deadline.tv_sec += secs;
+      deadline.tv_usec += usecs;
+      if (deadline.tv_usec >= 1000000)
+	{
+	  deadline.tv_sec += deadline.tv_usec / 1000000;
+	  deadline.tv_usec %= 1000000;
+	}
+      tvp = &tv;
+    }
+
+  if (pipe (fildes) < 0)
+    {
+      sys_error ("%s", _("cannot make pipe for asynchronous completion"));
+      return ((char *)NULL);
+    }
+
+  old_pid = last_made_pid;
+
+#if defined (JOB_CONTROL)
+  /* Put the child in a process group of its own so cancelling the completion
+     can kill everything it started.  FORK_NOTERM keeps the terminal with
+     the shell. */
+  old_pipeline_pgrp = pipeline_pgrp;
+  pipeline_pgrp = 0;
+  cleanup_the_pipeline ();
+#endif
+
+  pid = make_child ((char *)NULL, FORK_NOTERM);
+
+#if defined (JOB_CONTROL)
+  set_sigchld_handler ();
+  stop_making_children ();
+  if (pid != 0)
+    pipeline_pgrp = old_pipeline_pgrp;
+#else
+  stop_making_children ();
+#endif
+
+  if (pid < 0)
+    {
+      sys_error ("%s", _("cannot make child for asynchronous completion"));
+      last_made_pid = old_pid;
+      close (fildes[0]);
+      close (fildes[1]);
+      return ((char *)NULL);
+    }
+
+  if (pid == 0)
+    {
+      /* Reset the signal handlers in the child, but don't free the trap
+	 strings, the way command substitution does. */
+      reset_signal_handlers ();
+      subshell_environment |= SUBSHELL_COMSUB|SUBSHELL_RESETTRAP;
+      subshell_environment &= ~SUBSHELL_IGNTRAP;
+      interactive = 0;
+
+      rl_clear_signals ();
+      set_sigint_handler ();
+      if (signal_is_trapped (SIGTERM) == 0 && signal_is_hard_ignored (SIGTERM) == 0)
+	set_signal_handler (SIGTERM, SIG_DFL);
+      CLRINTERRUPT;
+
+#if defined (JOB_CONTROL)
+      /* Keep everything the function starts in our process group and away
+	 from the terminal, the way process substitution does. */
+      set_job_control (0);
+      pipeline_pgrp = getpid ();
+#endif
+
+      /* Anything the parent has buffered is the parent's to write. */
+      fpurge (stdout);
+      fpurge (stderr);
+
+      close (fildes[0]);
+
+      /* Don't jump back into readline if the function runs `exit'. */
+      result = setjmp_nosigs (top_level);
+      if (result == 0)
+	{
+	  (*func) (arg, fildes[1]);
+	  rc = EXECUTION_SUCCESS;
+	}
+      else
+	rc = last_command_exit_value;
+      close (fildes[1]);
+
+      last_command_exit_value = rc;
+      rc = run_exit_trap ();
+      exit (rc);
+    }
+
+#if defined (JOB_CONTROL) && defined (PGRP_PIPE)
+  /* The child is the first in its process group; let it run. */
+  close_pgrp_pipe ();
+#endif
+
+  close (fildes[1]);
+
+  infd = fileno (rl_instream ? rl_instream : stdin);
+  nfds = ((infd > fildes[0]) ? infd : fildes[0]) + 1;
+
+  buf = (char *)NULL;
+  blen = bsize = 0;
+  cancel = 0;
+
+  for (;;)
+    {
+      if (tvp)
+	{
+	  gettimeofday (&now, 0);
+	  tv.tv_sec = deadline.tv_sec - now.tv_sec;
+	  tv.tv_usec = deadline.tv_usec - now.tv_usec;
+	  if (tv.tv_usec < 0)
+	    {
+	      tv.tv_sec--;
+	      tv.tv_usec += 1000000;
+	    }
+	  if (tv.tv_sec < 0)
+	    {
+	      cancel = 1;		/* timed out */
+	      break;
+	    }
+	}
+
+      FD_ZERO (&readfds);
+      FD_SET (fildes[0], &readfds);
+      FD_SET (infd, &readfds);
+
+      result = select (nfds, &readfds, (fd_set *)NULL, (fd_set *)NULL, tvp);
+      if (result < 0 && errno == EINTR && interrupt_state == 0 && terminating_signal == 0)
+	continue;
+      if (result <= 0 || FD_ISSET (infd, &readfds))
+	{
+	  /* Error, timeout, interrupt, or the user typed something; leave
+	     the input for readline. */
+	  cancel = 1;
+	  break;
+	}
+
+      if (blen + 1024 >= bsize)
+	buf = (char *)xrealloc (buf, bsize += (bsize < 4096) ? 4096 : bsize);
+      nr = read (fildes[0], buf + blen, bsize - blen - 1);
+      if (nr < 0 && errno == EINTR)
+	continue;
+      if (nr < 0)
+	{
+	  cancel = 1;
+	  break;
+	}
+      if (nr == 0)
+	break;
+      blen += nr;
+    }
+
+  close (fildes[0]);
+
+  if (cancel)
+    {
+#if defined (JOB_CONTROL)
+      if (job_control)
+	killpg (pid, SIGTERM);
+#endif
+      kill (pid, SIGKILL);
+      FREE (buf);
+      buf = (char *)NULL;
+    }
+  else if (buf == 0)
+    buf = (char *)xmalloc (1);
+
+  wait_for (pid, JWAIT_NOTERM);
+  last_made_pid = old_pid;
+#if defined (JOB_CONTROL)
+  cleanup_the_pipeline ();
+#endif
+
+  if (buf)
+    {
+      buf[blen] = '\0';
+      *lenp = blen;
+    }
+  return buf;
+#else
+  *lenp = 0;
+  return ((char *)NULL);
+#endif /* !HAVE_SELECT */
+}
+
+/* Run a completion function in the child process and write its results to
+   FD: a line with its return status, the compspec options, and the readline
+   variables compopt can change, then the elements of COMPREPLY, each
+   followed by a NUL. */
+static void
+pcomp_async_function (void *arg, int fd)
+{
+  struct pcomp_async_fn *af;
+  int fval, i;
+  char hdr[128], **list;
+#if defined (ARRAY_VARS)
+  SHELL_VAR *v;
+  ARRAY *a;
+#endif
+
+  af = (struct pcomp_async_fn *)arg;
+  fval = execute_shell_function (af->f, af->cmdlist);
+
+  snprintf (hdr, sizeof (hdr), "%d %d %d %d %d %d %d\n", fval, af->cs->options,
+	    rl_filename_completion_desired, rl_full_quoting_desired,
+	    rl_completion_suppress_append, rl_filename_quoting_desired,
+	    rl_sort_completion_matches);
+  zwrite (fd, hdr, strlen (hdr));
+
+#if defined (ARRAY_VARS)
+  v = find_variable ("COMPREPLY");
+  if (v && array_p (v) == 0 && assoc_p (v) == 0)
+    v = convert_var_to_array (v);
+  if (v == 0 || array_p (v) == 0 || (a = array_cell (v)) == 0 || array_empty (a))
+    return;
+
+  list = array_to_argv (a, 0);
+  for (i = 0; list && list[i]; i++)
+    zwrite (fd, list[i], strlen (list[i]) + 1);
+  strvec_dispose (list);
+#endif
+}
+
+/* Run a completion command in the child process and write its output to
+   FD. */
+static void
+pcomp_async_command (void *arg, int fd)
+{
+  WORD_DESC *tw;
+
+  tw = command_substitute ((char *)arg, 0, 0);
+  if (tw && tw->word)
+    zwrite (fd, tw->word, strlen (tw->word));
+  if (tw)
+    dispose_word_desc (tw);
+}
+
 static STRINGLIST *
 gen_shell_function_matches (COMPSPEC *cs, const char *cmd, const char *text,
 			    char *line, int ind, WORD_LIST *lwords,
@@ -1051,9 +1510,13 @@ gen_shell_function_matches (COMPSPEC *cs, const char *cmd, const char *text,
   STRINGLIST *sl;
   SHELL_VAR *f, *v;
   WORD_LIST *cmdlist;
-  int fval, found, local_compgen;
+  int fval, found, local_compgen, async;
   sh_parser_state_t ps;
   sh_parser_state_t * restrict pps;
+  struct pcomp_async_fn af;
+  char *abuf, *t;
+  size_t alen;
+  int copts, fnc, fqc, sac, fqd, scm;
 #if defined (ARRAY_VARS)
   ARRAY *a;
 #endif
@@ -1095,7 +1558,47 @@ gen_shell_function_matches (COMPSPEC *cs, const char *cmd, const char *text,
       rl_clear_signals ();
     }
 
-  fval = execute_shell_function (f, cmdlist);  
+  /* Run the function in the background if the compspec asks for it.  A
+     function that returns 124 to have its completion retried means to load
+     a new compspec into this shell, which it can't do from the child, and
+     running it again here would repeat its side effects, so complain and
+     don't retry. */
+  async = 0;
+  abuf = (char *)NULL;
+  if (local_compgen == 0 && pcomp_async_p (cs))
+    {
+      af.f = f;
+      af.cmdlist = cmdlist;
+      af.cs = cs;
+      abuf = pcomp_async_run (pcomp_async_function, &af, &alen);
+      async = 1;
+      if (abuf == 0)
+	fval = EXECUTION_SUCCESS;	/* cancelled; no matches */
+      else if (sscanf (abuf, "%d %d %d %d %d %d %d", &fval, &copts, &fnc, &fqc, &sac, &fqd, &scm) != 7)
+	fval = EXECUTION_FAILURE;	/* the function exited */
+      else if (fval == EX_RETRYFAIL)
+	{
+	  internal_error (_("completion: function `%s' returned 124 and cannot be run with the `async' option"), funcname);
+	  fval = EXECUTION_FAILURE;
+	}
+      else
+	{
+	  /* Apply what compopt did in the child. */
+	  cs->options = copts;
+	  rl_filename_completion_desired = fnc;
+	  rl_full_quoting_desired = fqc;
+	  rl_completion_suppress_append = sac;
+	  rl_filename_quoting_desired = fqd;
+	  rl_sort_completion_matches = scm;
+	}
+    }
+
+  if (async == 0)
+    {
+      FREE (abuf);
+      abuf = (char *)NULL;
+      fval = execute_shell_function (f, cmdlist);  
+    }
 
   discard_unwind_frame ("gen-shell-function-matches");
   restore_parser_state (pps);
@@ -1115,6 +1618,26 @@ gen_shell_function_matches (COMPSPEC *cs, const char *cmd, const char *text,
   dispose_words (cmdlist);
   unbind_compfunc_variables (0);
 
+  if (async)
+    {
+      /* The completions follow the first line, separated by NULs. */
+      sl = (STRINGLIST *)NULL;
+      t = abuf ? strchr (abuf, '\n') : (char *)NULL;
+      if (t && found && t + 1 < abuf + alen)
+	{
+	  sl = strlist_create (16);
+	  for (t++; t < abuf + alen; t += strlen (t) + 1)
+	    {
+	      if (sl->list_len + 1 >= sl->list_size)
+		strlist_resize (sl, sl->list_size * 2);
+	      sl->list[sl->list_len++] = savestring (t);
+	    }
+	  sl->list[sl->list_len] = (char *)NULL;
+	}
+      FREE (abuf);
+      return (sl);
+    }
+
   /* The list of completions is returned in the array variable COMPREPLY. */
   v = find_variable ("COMPREPLY");
   if (v == 0)
@@ -1158,8 +1681,8 @@ gen_command_matches (COMPSPEC *cs, const char *cmd, const char *text,
 		     int nw, int cw)
 {
   char *csbuf, *cscmd, *t;
-  int ws, we;
-  size_t cmdlen, cmdsize, n;
+  int ws, we, async;
+  size_t cmdlen, cmdsize, n, cslen;
   WORD_LIST *cmdlist, *cl;
   WORD_DESC *tw;
   STRINGLIST *sl;
@@ -1193,16 +1716,29 @@ gen_command_matches (COMPSPEC *cs, const char *cmd, const char *text,
     }
   cscmd[cmdlen] = '\0';
 
-  tw = command_substitute (cscmd, 0, 0);
-  csbuf = tw ? tw->word : (char *)NULL;
-  if (tw)
-    dispose_word_desc (tw);
+  async = pcomp_async_p (cs);
+  if (async)
+    {
+      rl_clear_signals ();
+      csbuf = pcomp_async_run (pcomp_async_command, cscmd, &cslen);
+      rl_set_signals ();
+    }
+  else
+    {
+      tw = command_substitute (cscmd, 0, 0);
+      csbuf = tw ? tw->word : (char *)NULL;
+      if (tw)
+	dispose_word_desc (tw);
+    }
 
   /* Now clean up and destroy everything. */
   dispose_words (cmdlist);
   free (cscmd);
   unbind_compfunc_variables ("");
 
+  if (async)
+    QUIT;
+
   if (csbuf == 0 || *csbuf == '\0')
     {
       FREE (csbuf);
@@ -25,6 +25,17 @@
 #include "stdc.h"
 #include "hashlib.h"
 
+/* The split and expanded words from a compspec's -W option, kept between
+   completion attempts.  WORDS is in the original order; SORTED, built when
+   the list is reused, holds indices into WORDS ordered by value. */
+typedef struct compwords {
+  int refcount;
+  char *ifs;		/* $IFS the word list was split with */
+  int braceexp;		/* whether brace expansion was enabled */
+  STRINGLIST *words;
+  size_t *sorted;
+} COMPWORDS;
+
 typedef struct compspec {
   int refcount;
   unsigned long actions;
@@ -37,6 +48,7 @@ typedef struct compspec {
   char *command;
   char *lcommand;
   char *filterpat;
+  COMPWORDS *wordcache;	/* shared by copies; see compspec_copy */
 } COMPSPEC;
 
 /* Values for COMPSPEC actions.  These are things the shell knows how to
@@ -77,8 +89,9 @@ typedef struct compspec {
 #define COPT_PLUSDIRS	(1<<7)
 #define COPT_NOSORT	(1<<8)
 #define COPT_FULLQUOTE	(1<<9)
+#define COPT_ASYNC	(1<<10)
 
-#define COPT_LASTUSER	COPT_FULLQUOTE
+#define COPT_LASTUSER	COPT_ASYNC
 
 #define PCOMP_RETRYFAIL (COPT_LASTUSER << 1)
 #define PCOMP_NOTFOUND	(COPT_LASTUSER << 2)
@@ -152,6 +165,8 @@ extern COMPSPEC *compspec_create (void);
 extern void compspec_dispose (COMPSPEC *);
 extern COMPSPEC *compspec_copy (COMPSPEC *);
 
+extern void compwords_flush (COMPWORDS *);
+
 extern void progcomp_create (void);
 extern void progcomp_flush (void);
 extern void progcomp_dispose (void);
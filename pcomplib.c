@@ -45,6 +45,9 @@ HASH_TABLE *prog_completes = (HASH_TABLE *)NULL;
 
 static void free_progcomp (PTR_T);
 
+static COMPWORDS *compwords_create (void);
+static void compwords_dispose (COMPWORDS *);
+
 COMPSPEC *
 compspec_create (void)
 {
@@ -64,6 +67,7 @@ compspec_create (void)
   ret->command = (char *)NULL;
   ret->lcommand = (char *)NULL;
   ret->filterpat = (char *)NULL;
+  ret->wordcache = (COMPWORDS *)NULL;
 
   return ret;
 }
@@ -82,6 +86,8 @@ compspec_dispose (COMPSPEC *cs)
       FREE (cs->command);
       FREE (cs->lcommand);
       FREE (cs->filterpat);
+      if (cs->wordcache)
+	compwords_dispose (cs->wordcache);
 
       free (cs);
     }
@@ -107,9 +113,57 @@ compspec_copy (COMPSPEC *cs)
   new->lcommand = STRDUP (cs->lcommand);
   new->filterpat = STRDUP (cs->filterpat);
 
+  /* Completion works on a copy of the compspec, so the copy shares the
+     original's word list cache, creating it if necessary.  A compspec
+     defined with `complete' starts with no cache, so redefining one
+     discards what was cached for the old definition. */
+  if (cs->words && cs->wordcache == 0)
+    cs->wordcache = compwords_create ();
+  new->wordcache = cs->wordcache;
+  if (new->wordcache)
+    new->wordcache->refcount++;
+
   return new;
 }
 
+static COMPWORDS *
+compwords_create (void)
+{
+  COMPWORDS *ret;
+
+  ret = (COMPWORDS *)xmalloc (sizeof (COMPWORDS));
+  ret->refcount = 1;
+  ret->ifs = (char *)NULL;
+  ret->braceexp = 0;
+  ret->words = (STRINGLIST *)NULL;
+  ret->sorted = (size_t *)NULL;
+
+  return ret;
+}
+
+void
+compwords_flush (COMPWORDS *cw)
+{
+  FREE (cw->ifs);
+  cw->ifs = (char *)NULL;
+  if (cw->words)
+    strlist_dispose (cw->words);
+  cw->words = (STRINGLIST *)NULL;
+  FREE (cw->sorted);
+  cw->sorted = (size_t *)NULL;
+}
+
+static void
+compwords_dispose (COMPWORDS *cw)
+{
+  cw->refcount--;
+  if (cw->refcount == 0)
+    {
+      compwords_flush (cw);
+      free (cw);
+    }
+}
+
 void
 progcomp_create (void)
 {
@@ -160,8 +214,7 @@ progcomp_remove (const char *cmd)
     {
       if (item->data)
 	free_progcomp (item->data);
-      free (item->key);
-      free (item);
+      hash_dispose_item (item);
       return (1);
     }
   return (0);
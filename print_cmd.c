@@ -40,6 +40,10 @@
 #include "flags.h"
 #include <y.tab.h>	/* use <...> so we pick it up from the build directory */
 #include "input.h"
+#include "parser.h"
+#include "execute_cmd.h"
+
+#include "posixtime.h"
 
 #include "shmbutil.h"
 
@@ -109,8 +113,25 @@ int command_string_index = 0;
 int xtrace_fd = -1;
 FILE *xtrace_fp = 0;
 
+/* Set from BASH_XTRACEOPTS.  XTRACE_JSON writes each trace record as a
+   line of JSON instead of expanding $PS4; XTRACE_BUFFERED lets stdio
+   buffer output to BASH_XTRACEFD instead of flushing every line. */
+static int xtrace_json = 0;
+static int xtrace_buffered = 0;
+
+/* Number of words in the JSON record being written. */
+static int xtrace_json_nwords;
+
 #define CHECK_XTRACE_FP	xtrace_fp = (xtrace_fp ? xtrace_fp : stderr)
 
+/* Trace output to stderr is never buffered, since it's interleaved with
+   the shell's error messages. */
+#define XTRACE_FLUSH() \
+  do { \
+    if (xtrace_buffered == 0 || xtrace_fd < 0) \
+      fflush (xtrace_fp); \
+  } while (0)
+
 /* shell expansion characters: used in print_redirection_list */
 #define EXPCHAR(c) ((c) == '{' || (c) == '~' || (c) == '$' || (c) == '`')
 
@@ -439,6 +460,140 @@ xtrace_fdchk (int fd)
     xtrace_reset ();
 }
 
+/* Write any buffered trace output if FD is the trace file descriptor and
+   a redirection is about to replace it, so the output goes where it was
+   traced to. */
+void
+xtrace_fdflush (int fd)
+{
+  if (fd == xtrace_fd && xtrace_buffered && xtrace_fp)
+    fflush (xtrace_fp);
+}
+
+void
+xtrace_set_options (int json, int buffered)
+{
+  if (xtrace_buffered && buffered == 0 && xtrace_fp)
+    fflush (xtrace_fp);
+  xtrace_json = json;
+  xtrace_buffered = buffered;
+}
+
+/* Write any buffered trace output.  This is called before the shell forks,
+   so the child doesn't write the parent's pending output a second time,
+   and before it execs, which would discard it. */
+void
+xtrace_flush (void)
+{
+  if (xtrace_buffered && xtrace_fp)
+    fflush (xtrace_fp);
+}
+
+/* Write STRING to the trace file as a JSON string.  JSON text has to be
+   UTF-8 whatever the locale, so a byte that doesn't start a valid UTF-8
+   character is written as the code point with the same value, as if
+   STRING were Latin-1. */
+static void
+xtrace_json_string (const char *string)
+{
+  const unsigned char *s;
+  int n;
+
+  putc ('"', xtrace_fp);
+  for (s = (const unsigned char *)string; s && *s; s++)
+    {
+      if (*s == '"' || *s == '\\')
+	{
+	  putc ('\\', xtrace_fp);
+	  putc (*s, xtrace_fp);
+	}
+      else if (*s == '\n')
+	fputs ("\\n", xtrace_fp);
+      else if (*s == '\t')
+	fputs ("\\t", xtrace_fp);
+      else if (*s >= 0x80 && (n = utf8_mblen ((const char *)s, 4)) > 1)
+	{
+	  /* STRING's terminating NUL stops utf8_mblen early */
+	  fwrite (s, 1, n, xtrace_fp);
+	  s += n - 1;
+	}
+      else if (*s < 0x20 || *s >= 0x7f)
+	fprintf (xtrace_fp, "\\u%04x", *s);
+      else
+	putc (*s, xtrace_fp);
+    }
+  putc ('"', xtrace_fp);
+}
+
+static void
+xtrace_json_word (const char *word)
+{
+  if (xtrace_json_nwords++)
+    putc (',', xtrace_fp);
+  xtrace_json_string (word);
+}
+
+/* Start a JSON trace record: the monotonic time in seconds, the process
+   id, the function nesting level, the source file and line, and an array
+   of the words being traced, the first of which is WORD if non-null. */
+static void
+xtrace_json_begin (const char *word)
+{
+  struct timeval tv;
+  char *file;
+#if defined (HAVE_CLOCK_GETTIME) && defined (CLOCK_MONOTONIC)
+  struct timespec ts;
+#endif
+#if defined (ARRAY_VARS)
+  SHELL_VAR *v;
+  ARRAY *a;
+#endif
+
+#if defined (HAVE_CLOCK_GETTIME) && defined (CLOCK_MONOTONIC)
+  if (clock_gettime (CLOCK_MONOTONIC, &ts) == 0)
+    {
+      tv.tv_sec = ts.tv_sec;
+      tv.tv_usec = ts.tv_nsec / 1000;
+    }
+  else
+#endif
+  gettimeofday (&tv, NULL);
+
+  file = (char *)NULL;
+#if defined (ARRAY_VARS)
+  GET_ARRAY_FROM_VAR ("BASH_SOURCE", v, a);
+  if (a)
+    file = array_reference (a, 0);
+#endif
+  if (file == 0)
+    file = dollar_vars[0] ? dollar_vars[0] : shell_name;
+
+  fprintf (xtrace_fp, "{\"ts\":%jd.%06ld,\"pid\":%ld,\"depth\":%d,\"src\":",
+	   (intmax_t)tv.tv_sec, (long)tv.tv_usec, (long)getpid (), funcnest);
+  xtrace_json_string (file);
+  fprintf (xtrace_fp, ",\"line\":%d,\"cmd\":[", line_number);
+
+  xtrace_json_nwords = 0;
+  if (word)
+    xtrace_json_word (word);
+}
+
+static void
+xtrace_json_words (WORD_LIST *list)
+{
+  WORD_LIST *w;
+
+  for (w = list; w; w = w->next)
+    xtrace_json_word (w->word->word ? w->word->word : "");
+}
+
+static void
+xtrace_json_end (void)
+{
+  fputs ("]}\n", xtrace_fp);
+  XTRACE_FLUSH ();
+}
+
 /* Return a string denoting what our indirection level is. */
 
 char *
@@ -517,6 +672,16 @@ xtrace_print_assignment (char *name, char *value, int assign_list, int xflags)
 
   CHECK_XTRACE_FP;
 
+  if (xtrace_json)
+    {
+      nval = (char *)xmalloc (strlen (name) + strlen (value) + 4);
+      sprintf (nval, assign_list ? "%s=(%s)" : "%s=%s", name, value);
+      xtrace_json_begin (nval);
+      xtrace_json_end ();
+      free (nval);
+      return;
+    }
+
   if (xflags)
     fprintf (xtrace_fp, "%s", indirection_level_string ());
 
@@ -538,7 +703,7 @@ xtrace_print_assignment (char *name, char *value, int assign_list, int xflags)
   if (nval != value)
     FREE (nval);
 
-  fflush (xtrace_fp);
+  XTRACE_FLUSH ();
 }
 
 /* A function to print the words of a simple command when set -x is on.  Also used to
@@ -553,6 +718,14 @@ xtrace_print_word_list (WORD_LIST *list, int xtflags)
 
   CHECK_XTRACE_FP;
 
+  if (xtrace_json)
+    {
+      xtrace_json_begin ((char *)NULL);
+      xtrace_json_words (list);
+      xtrace_json_end ();
+      return;
+    }
+
   if (xtflags&1)
     fprintf (xtrace_fp, "%s", indirection_level_string ());
 
@@ -579,7 +752,7 @@ xtrace_print_word_list (WORD_LIST *list, int xtflags)
 	fprintf (xtrace_fp, "%s%s", t, w->next ? " " : "");
     }
   fprintf (xtrace_fp, "\n");
-  fflush (xtrace_fp);
+  XTRACE_FLUSH ();
 }
 
 static void
@@ -609,6 +782,15 @@ void
 xtrace_print_for_command_head (FOR_COM *for_command)
 {
   CHECK_XTRACE_FP;
+  if (xtrace_json)
+    {
+      xtrace_json_begin ("for");
+      xtrace_json_word (for_command->name->word);
+      xtrace_json_word ("in");
+      xtrace_json_words (for_command->map_list);
+      xtrace_json_end ();
+      return;
+    }
   fprintf (xtrace_fp, "%s", indirection_level_string ());
   fprintf (xtrace_fp, "for %s in ", for_command->name->word);
   xtrace_print_word_list (for_command->map_list, 2);
@@ -668,6 +850,15 @@ void
 xtrace_print_select_command_head (SELECT_COM *select_command)
 {
   CHECK_XTRACE_FP;
+  if (xtrace_json)
+    {
+      xtrace_json_begin ("select");
+      xtrace_json_word (select_command->name->word);
+      xtrace_json_word ("in");
+      xtrace_json_words (select_command->map_list);
+      xtrace_json_end ();
+      return;
+    }
   fprintf (xtrace_fp, "%s", indirection_level_string ());
   fprintf (xtrace_fp, "select %s in ", select_command->name->word);
   xtrace_print_word_list (select_command->map_list, 2);
@@ -742,6 +933,14 @@ void
 xtrace_print_case_command_head (CASE_COM *case_command)
 {
   CHECK_XTRACE_FP;
+  if (xtrace_json)
+    {
+      xtrace_json_begin ("case");
+      xtrace_json_word (case_command->word->word);
+      xtrace_json_word ("in");
+      xtrace_json_end ();
+      return;
+    }
   fprintf (xtrace_fp, "%s", indirection_level_string ());
   fprintf (xtrace_fp, "case %s in\n", case_command->word->word);
 }
@@ -957,6 +1156,26 @@ xtrace_print_cond_term (int type, int invert, WORD_DESC *op, char *arg1, char *a
 {
   CHECK_XTRACE_FP;
   command_string_index = 0;
+  if (xtrace_json)
+    {
+      xtrace_json_begin ("[[");
+      if (invert)
+	xtrace_json_word ("!");
+      if (type == COND_UNARY)
+	{
+	  xtrace_json_word (op->word);
+	  xtrace_json_word (arg1 ? arg1 : "");
+	}
+      else if (type == COND_BINARY)
+	{
+	  xtrace_json_word (arg1 ? arg1 : "");
+	  xtrace_json_word (op->word);
+	  xtrace_json_word (arg2 ? arg2 : "");
+	}
+      xtrace_json_word ("]]");
+      xtrace_json_end ();
+      return;
+    }
   fprintf (xtrace_fp, "%s", indirection_level_string ());
   fprintf (xtrace_fp, "[[ ");
   if (invert)
@@ -976,7 +1195,7 @@ xtrace_print_cond_term (int type, int invert, WORD_DESC *op, char *arg1, char *a
 
   fprintf (xtrace_fp, " ]]\n");
 
-  fflush (xtrace_fp);
+  XTRACE_FLUSH ();
 }	  
 #endif /* COND_COMMAND */
 
@@ -988,13 +1207,21 @@ xtrace_print_arith_cmd (WORD_LIST *list)
   WORD_LIST *w;
 
   CHECK_XTRACE_FP;
+  if (xtrace_json)
+    {
+      xtrace_json_begin ("((");
+      xtrace_json_words (list);
+      xtrace_json_word ("))");
+      xtrace_json_end ();
+      return;
+    }
   fprintf (xtrace_fp, "%s", indirection_level_string ());
   fprintf (xtrace_fp, "(( ");
   for (w = list; w; w = w->next)
     fprintf (xtrace_fp, "%s%s", w->word->word, w->next ? " " : "");
   fprintf (xtrace_fp, " ))\n");
 
-  fflush (xtrace_fp);
+  XTRACE_FLUSH ();
 }
 #endif
 
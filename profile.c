@@ -0,0 +1,681 @@
+/* profile.c -- time shell functions and the commands they run. */
+
+/* Copyright (C) 2024 Free Software Foundation, Inc.
+
+   This file is part of GNU Bash, the Bourne Again SHell.
+
+   Bash is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Bash is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Bash.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Assigning a filename to BASH_PROFILE starts the profiler; unsetting it
+   or exiting the shell stops it and writes a report to that file.  The
+   report lists each shell function with its call count and the wall clock
+   and cpu time spent in it, both including (total) and excluding (self)
+   the functions it calls, and each source line that ran a simple command
+   with the same numbers for that command.  Forks and execs are counted
+   too.  A second file, with `.collapsed' appended to the name, gets the
+   self time of each distinct call stack in microseconds, one
+   `main;f;g usec' line per stack, which is the input format for the
+   common flame graph scripts.
+
+   Cpu times are those of the shell process itself; time spent in child
+   processes shows up only in the wall clock times. */
+
+#include "config.h"
+
+#include <stdio.h>
+#include "bashtypes.h"
+#if defined (HAVE_UNISTD_H)
+#  include <unistd.h>
+#endif
+#include "posixtime.h"
+#if defined (HAVE_SYS_RESOURCE_H) && defined (HAVE_GETRUSAGE)
+#  include <sys/resource.h>
+#endif
+
+#include "bashansi.h"
+#include "bashintl.h"
+
+#include "shell.h"
+#include "hashlib.h"
+#include "profile.h"
+
+#include "builtins/common.h"
+
+#include <glob/strmatch.h>
+#include <glob/glob.h>
+
+/* The bash malloc keeps statistics when it's built with MALLOC_DEBUG. */
+#if defined (MALLOC_DEBUG) && defined (USING_BASH_MALLOC)
+#  undef FASTCOPY		/* imalloc.h has its own */
+#  include <malloc/mstats.h>
+#endif
+
+typedef struct profile_stats {
+  char *name;			/* function name or FILE:LINE */
+  char *info;			/* source file or command name */
+  intmax_t count;
+  intmax_t wall, cpu;		/* total microseconds */
+  intmax_t self_wall, self_cpu;	/* not counting called functions */
+  intmax_t forks, execs;
+  int active;			/* calls in progress, for recursion */
+} PROFILE_STATS;
+
+/* A simple command that is running. */
+typedef struct profile_line {
+  PROFILE_STATS *stats;
+  intmax_t wall, cpu;		/* clocks when the command started */
+  intmax_t forks, execs;
+} PROFILE_LINE;
+
+typedef struct profile_frame {
+  PROFILE_STATS *stats;
+  char *stack;			/* main;f;g */
+  intmax_t wall, cpu;		/* clocks when the call started */
+  intmax_t forks, execs;	/* counters when the call started */
+  intmax_t cwall, ccpu;		/* totals of the functions this one called */
+  intmax_t cforks, cexecs;
+} PROFILE_FRAME;
+
+int profiling_enabled = 0;
+
+struct shell_stats shell_stats;
+
+extern sh_obj_pool_t varpool, bucket_pool;
+#if defined (ARRAY_VARS)
+extern sh_obj_pool_t aepool;
+#endif
+
+static char *profile_file = (char *)NULL;
+static pid_t profile_pid;
+
+/* The process counters when profiling started. */
+static intmax_t profile_forks;
+static intmax_t profile_execs;
+
+static HASH_TABLE *profile_functions = (HASH_TABLE *)NULL;
+static HASH_TABLE *profile_lines = (HASH_TABLE *)NULL;
+static HASH_TABLE *profile_stacks = (HASH_TABLE *)NULL;
+
+static PROFILE_FRAME *frames = (PROFILE_FRAME *)NULL;
+static int nframes = 0;
+static int maxframes = 0;
+
+static PROFILE_LINE *lines = (PROFILE_LINE *)NULL;
+static int nlines = 0;
+static int maxlines = 0;
+
+static PROFILE_STATS *main_stats;
+
+static char *linekey = (char *)NULL;
+static size_t linekey_size = 0;
+
+static void
+profile_clock (intmax_t *wall, intmax_t *cpu)
+{
+  struct timeval tv;
+#if defined (HAVE_CLOCK_GETTIME)
+  struct timespec ts;
+#endif
+#if defined (HAVE_GETRUSAGE)
+  struct rusage ru;
+#endif
+
+#if defined (HAVE_CLOCK_GETTIME) && defined (CLOCK_MONOTONIC)
+  if (clock_gettime (CLOCK_MONOTONIC, &ts) == 0)
+    *wall = (intmax_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+  else
+#endif
+    {
+      gettimeofday (&tv, NULL);
+      *wall = (intmax_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    }
+
+#if defined (HAVE_CLOCK_GETTIME) && defined (CLOCK_PROCESS_CPUTIME_ID)
+  if (clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &ts) == 0)
+    {
+      *cpu = (intmax_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+      return;
+    }
+#endif
+#if defined (HAVE_GETRUSAGE)
+  getrusage (RUSAGE_SELF, &ru);
+  *cpu = (intmax_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000 +
+	 ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+#else
+  *cpu = 0;
+#endif
+}
+
+static void
+free_stats (void *data)
+{
+  PROFILE_STATS *s;
+
+  s = (PROFILE_STATS *)data;
+  FREE (s->info);
+  free (s);
+}
+
+/* Return the statistics for KEY in TABLE, creating them if necessary. */
+static PROFILE_STATS *
+profile_stats (HASH_TABLE *table, const char *key)
+{
+  BUCKET_CONTENTS *b;
+  PROFILE_STATS *s;
+
+  b = hash_search (key, table, 0);
+  if (b)
+    return ((PROFILE_STATS *)b->data);
+
+  b = hash_insert (savestring (key), table, HASH_NOSRCH);
+  s = (PROFILE_STATS *)xmalloc (sizeof (PROFILE_STATS));
+  memset (s, 0, sizeof (PROFILE_STATS));
+  s->name = b->key;
+  b->data = s;
+  return s;
+}
+
+static void
+profile_add_stack (const char *stack, intmax_t usec)
+{
+  BUCKET_CONTENTS *b;
+
+  b = hash_search (stack, profile_stacks, 0);
+  if (b == 0)
+    {
+      b = hash_insert (savestring (stack), profile_stacks, HASH_NOSRCH);
+      b->data = xmalloc (sizeof (intmax_t));
+      *(intmax_t *)b->data = 0;
+    }
+  *(intmax_t *)b->data += usec;
+}
+
+static void
+profile_reset (void)
+{
+  while (nframes > 0)
+    free (frames[--nframes].stack);
+  nlines = 0;
+
+  hash_flush (profile_functions, free_stats);
+  hash_flush (profile_lines, free_stats);
+  hash_flush (profile_stacks, (sh_free_func_t *)NULL);
+  main_stats = (PROFILE_STATS *)NULL;
+}
+
+static int
+profile_push (const char *name, const char *file)
+{
+  PROFILE_FRAME *f;
+  PROFILE_STATS *s;
+  char *parent;
+
+  if (nframes >= maxframes)
+    {
+      maxframes += 16;
+      frames = (PROFILE_FRAME *)xrealloc (frames, maxframes * sizeof (PROFILE_FRAME));
+    }
+
+  s = profile_stats (profile_functions, name);
+  if (s->info == 0)
+    s->info = savestring (file ? file : "");
+  s->count++;
+  s->active++;
+
+  f = frames + nframes;
+  f->stats = s;
+  if (nframes == 0)
+    f->stack = savestring (name);
+  else
+    {
+      parent = frames[nframes - 1].stack;
+      f->stack = (char *)xmalloc (strlen (parent) + strlen (name) + 2);
+      sprintf (f->stack, "%s;%s", parent, name);
+    }
+
+  profile_clock (&f->wall, &f->cpu);
+  f->forks = shell_stats.forks;
+  f->execs = shell_stats.execs;
+  f->cwall = f->ccpu = f->cforks = f->cexecs = 0;
+
+  return (nframes++);
+}
+
+/* Pop the innermost frame, which finished at WALL and CPU, and charge its
+   time to the function and to its caller. */
+static void
+profile_pop (intmax_t wall, intmax_t cpu)
+{
+  PROFILE_FRAME *f, *p;
+  PROFILE_STATS *s;
+  intmax_t twall, tcpu, tforks, texecs;
+
+  f = frames + --nframes;
+  s = f->stats;
+
+  twall = wall - f->wall;
+  tcpu = cpu - f->cpu;
+  tforks = shell_stats.forks - f->forks;
+  texecs = shell_stats.execs - f->execs;
+
+  s->self_wall += twall - f->cwall;
+  s->self_cpu += tcpu - f->ccpu;
+  s->forks += tforks - f->cforks;
+  s->execs += texecs - f->cexecs;
+  /* Only the outermost of a set of recursive calls adds to the total. */
+  if (--s->active == 0)
+    {
+      s->wall += twall;
+      s->cpu += tcpu;
+    }
+
+  if (nframes > 0)
+    {
+      p = f - 1;
+      p->cwall += twall;
+      p->ccpu += tcpu;
+      p->cforks += tforks;
+      p->cexecs += texecs;
+    }
+
+  profile_add_stack (f->stack, twall - f->cwall);
+  free (f->stack);
+}
+
+void
+profile_start (const char *file)
+{
+  char *cwd;
+
+  /* A relative name is relative to the directory the shell was in when
+     the variable was set, not the one it exits in. */
+  FREE (profile_file);
+  if (ABSPATH (file))
+    profile_file = savestring (file);
+  else
+    {
+      cwd = get_working_directory ("BASH_PROFILE");
+      profile_file = make_absolute (file, cwd);
+      FREE (cwd);
+    }
+
+  /* Changing the value just changes where the report goes. */
+  if (profiling_enabled && profile_pid == getpid ())
+    return;
+
+  if (profile_functions == 0)
+    {
+      profile_functions = hash_create (64);
+      profile_lines = hash_create (256);
+      profile_stacks = hash_create (64);
+    }
+  profile_reset ();
+
+  profile_pid = getpid ();
+  profile_forks = shell_stats.forks;
+  profile_execs = shell_stats.execs;
+  profiling_enabled = 1;
+
+  profile_push ("main", (char *)NULL);
+  main_stats = frames[0].stats;
+}
+
+/* Start timing a call to the shell function NAME.  Returns a value to
+   pass to profile_leave () when the call returns. */
+int
+profile_enter (const char *name)
+{
+  FUNCTION_DEF *def;
+
+  def = find_function_def (name);
+  return (profile_push (name, def ? def->source_file : (char *)NULL));
+}
+
+/* The call that profile_enter () returned DEPTH for has returned.  Calls it
+   made that were abandoned by a longjmp end now too. */
+void
+profile_leave (int depth)
+{
+  intmax_t wall, cpu;
+
+  if (profiling_enabled == 0 || depth < 1 || depth >= nframes)
+    return;
+
+  profile_clock (&wall, &cpu);
+  while (nframes > depth)
+    profile_pop (wall, cpu);
+}
+
+/* Record that the simple command CMD on line LINE of the current source
+   file is starting.  Returns a value to pass to profile_line_end (). */
+int
+profile_line_start (int line, const char *cmd)
+{
+  PROFILE_LINE *l;
+  PROFILE_STATS *s;
+  char *file;
+  size_t len;
+#if defined (ARRAY_VARS)
+  SHELL_VAR *v;
+  ARRAY *a;
+#endif
+
+  file = (char *)NULL;
+#if defined (ARRAY_VARS)
+  GET_ARRAY_FROM_VAR ("BASH_SOURCE", v, a);
+  if (a)
+    file = array_reference (a, 0);
+#endif
+  if (file == 0)
+    file = dollar_vars[0] ? dollar_vars[0] : shell_name;
+
+  len = strlen (file) + INT_STRLEN_BOUND (int) + 2;
+  if (len > linekey_size)
+    linekey = (char *)xrealloc (linekey, linekey_size = len);
+  sprintf (linekey, "%s:%d", file, line);
+
+  s = profile_stats (profile_lines, linekey);
+  if (s->info == 0)
+    s->info = savestring (cmd ? cmd : "");
+  s->count++;
+  s->active++;
+
+  if (nlines >= maxlines)
+    {
+      maxlines += 16;
+      lines = (PROFILE_LINE *)xrealloc (lines, maxlines * sizeof (PROFILE_LINE));
+    }
+  l = lines + nlines;
+  l->stats = s;
+  profile_clock (&l->wall, &l->cpu);
+  l->forks = shell_stats.forks;
+  l->execs = shell_stats.execs;
+
+  return (++nlines);
+}
+
+static void
+profile_line_pop (intmax_t wall, intmax_t cpu)
+{
+  PROFILE_LINE *l;
+  PROFILE_STATS *s;
+
+  l = lines + --nlines;
+  s = l->stats;
+  /* As with functions, a line run again by a recursive call it made is
+     only charged once. */
+  if (--s->active == 0)
+    {
+      s->wall += wall - l->wall;
+      s->cpu += cpu - l->cpu;
+      s->forks += shell_stats.forks - l->forks;
+      s->execs += shell_stats.execs - l->execs;
+    }
+}
+
+/* The command that profile_line_start () returned DEPTH for has finished,
+   normally or by a longjmp out of it. */
+void
+profile_line_end (int depth)
+{
+  intmax_t wall, cpu;
+
+  if (profiling_enabled == 0 || depth < 1 || depth > nlines)
+    return;
+
+  profile_clock (&wall, &cpu);
+  while (nlines >= depth)
+    profile_line_pop (wall, cpu);
+}
+
+static int
+stats_compare (const void *a, const void *b)
+{
+  PROFILE_STATS *s1, *s2;
+
+  s1 = *(PROFILE_STATS **)a;
+  s2 = *(PROFILE_STATS **)b;
+  if (s1->self_wall != s2->self_wall)
+    return (s1->self_wall < s2->self_wall ? 1 : -1);
+  if (s1->wall != s2->wall)
+    return (s1->wall < s2->wall ? 1 : -1);
+  return (strcmp (s1->name, s2->name));
+}
+
+/* Return the statistics in TABLE as a NULL-terminated array, most
+   expensive first. */
+static PROFILE_STATS **
+sorted_stats (HASH_TABLE *table)
+{
+  PROFILE_STATS **list;
+  BUCKET_CONTENTS *b;
+  int i, n;
+
+  list = (PROFILE_STATS **)xmalloc ((HASH_ENTRIES (table) + 1) * sizeof (PROFILE_STATS *));
+  for (i = n = 0; i < table->nbuckets; i++)
+    for (b = hash_items (i, table); b; b = b->next)
+      list[n++] = (PROFILE_STATS *)b->data;
+  list[n] = (PROFILE_STATS *)NULL;
+
+  qsort (list, n, sizeof (PROFILE_STATS *), stats_compare);
+  return list;
+}
+
+static void
+print_msec (FILE *fp, intmax_t usec)
+{
+  fprintf (fp, " %9jd.%03d", usec / 1000, (int)(usec % 1000));
+}
+
+static void
+profile_report (void)
+{
+  FILE *fp;
+  PROFILE_STATS **list, *s;
+  BUCKET_CONTENTS *b;
+  char *cfile;
+  int i;
+
+  fp = fopen (profile_file, "w");
+  if (fp == 0)
+    {
+      file_error (profile_file);
+      return;
+    }
+
+  fprintf (fp, "# bash profile of process %ld: %jd.%06d seconds, %jd.%06d cpu seconds, %jd forks, %jd execs\n",
+	   (long)profile_pid,
+	   main_stats->wall / 1000000, (int)(main_stats->wall % 1000000),
+	   main_stats->cpu / 1000000, (int)(main_stats->cpu % 1000000),
+	   shell_stats.forks - profile_forks, shell_stats.execs - profile_execs);
+  fprintf (fp, "# times are in milliseconds; cpu times are for the shell process only\n");
+
+  fprintf (fp, "\n# functions, by self time\n");
+  fprintf (fp, "#%9s %13s %13s %13s %13s %7s %7s  %s\n", "calls", "total",
+	   "self", "total-cpu", "self-cpu", "forks", "execs", "function");
+  list = sorted_stats (profile_functions);
+  for (i = 0; (s = list[i]); i++)
+    {
+      fprintf (fp, " %9jd", s->count);
+      print_msec (fp, s->wall);
+      print_msec (fp, s->self_wall);
+      print_msec (fp, s->cpu);
+      print_msec (fp, s->self_cpu);
+      fprintf (fp, " %7jd %7jd  %s", s->forks, s->execs, s->name);
+      if (s->info && *s->info)
+	fprintf (fp, " (%s)", s->info);
+      fprintf (fp, "\n");
+    }
+  free (list);
+
+  fprintf (fp, "\n# lines, by time\n");
+  fprintf (fp, "#%9s %13s %13s %7s %7s  %s\n", "count", "total",
+	   "total-cpu", "forks", "execs", "line");
+  list = sorted_stats (profile_lines);
+  for (i = 0; (s = list[i]); i++)
+    {
+      fprintf (fp, " %9jd", s->count);
+      print_msec (fp, s->wall);
+      print_msec (fp, s->cpu);
+      fprintf (fp, " %7jd %7jd  %s", s->forks, s->execs, s->name);
+      if (s->info && *s->info)
+	fprintf (fp, " (%s)", s->info);
+      fprintf (fp, "\n");
+    }
+  free (list);
+
+  fclose (fp);
+
+  cfile = (char *)xmalloc (strlen (profile_file) + 11);
+  sprintf (cfile, "%s.collapsed", profile_file);
+  fp = fopen (cfile, "w");
+  if (fp == 0)
+    file_error (cfile);
+  else
+    {
+      for (i = 0; i < profile_stacks->nbuckets; i++)
+	for (b = hash_items (i, profile_stacks); b; b = b->next)
+	  fprintf (fp, "%s %jd\n", b->key, *(intmax_t *)b->data);
+      fclose (fp);
+    }
+  free (cfile);
+}
+
+/* Stop profiling, end any calls still in progress, and write the report
+   if this is the process that started it. */
+void
+profile_stop (void)
+{
+  intmax_t wall, cpu;
+
+  if (profiling_enabled == 0)
+    return;
+
+  profile_clock (&wall, &cpu);
+  while (nlines > 0)
+    profile_line_pop (wall, cpu);
+  while (nframes > 0)
+    profile_pop (wall, cpu);
+  profiling_enabled = 0;
+
+  if (profile_pid == getpid ())
+    profile_report ();
+  profile_reset ();
+}
+
+/* The counters reported by BASH_STATS, in the order they are listed.
+   Each one is either a member of shell_stats or a counter kept by one of
+   the libraries.  Gauges measure something currently in use and are not
+   rebased when the counters are reset. */
+
+#define STATS_GAUGE	0x01
+
+typedef struct stats_entry {
+  const char *name;
+  int flags;
+  intmax_t *ivalue;
+  unsigned long *uvalue;
+} STATS_ENTRY;
+
+#if defined (MALLOC_DEBUG) && defined (USING_BASH_MALLOC)
+static unsigned long malloc_bytesused;
+#endif
+
+static STATS_ENTRY stats_table[] = {
+  { "forks",		0, &shell_stats.forks, 0 },
+  { "fork_retries",	0, &shell_stats.fork_retries, 0 },
+  { "fork_failures",	0, &shell_stats.fork_failures, 0 },
+  { "execs",		0, &shell_stats.execs, 0 },
+  { "subshells",	0, &shell_stats.subshells, 0 },
+  { "comsubs",		0, &shell_stats.comsubs, 0 },
+  { "procsubs",		0, &shell_stats.procsubs, 0 },
+  { "var_lookups",	0, &shell_stats.var_lookups, 0 },
+  { "hash_searches",	0, 0, &hash_nsearches },
+  { "hash_probes",	0, 0, &hash_nprobes },
+  { "globs",		0, &shell_stats.globs, 0 },
+  { "glob_dirents",	0, 0, &glob_ndirents },
+  { "pattern_matches",	0, 0, &strmatch_ncalls },
+  { "history_adds",	0, &shell_stats.history_adds, 0 },
+  { "history_reads",	0, &shell_stats.history_reads, 0 },
+  { "history_writes",	0, &shell_stats.history_writes, 0 },
+  { "xmalloc_calls",	0, 0, &xmalloc_ncalls },
+  { "xmalloc_bytes",	0, 0, &xmalloc_nbytes },
+#if defined (MALLOC_DEBUG) && defined (USING_BASH_MALLOC)
+  { "malloc_bytes_in_use", STATS_GAUGE, 0, &malloc_bytesused },
+#endif
+  { "variables",	STATS_GAUGE, 0, &varpool.ninuse },
+  { "variables_max",	STATS_GAUGE, 0, &varpool.maxinuse },
+  { "hash_items",	STATS_GAUGE, 0, &bucket_pool.ninuse },
+#if defined (ARRAY_VARS)
+  { "array_elements",	STATS_GAUGE, 0, &aepool.ninuse },
+#endif
+  { (char *)NULL, 0, 0, 0 }
+};
+
+#define NSTATS	((int)(sizeof (stats_table) / sizeof (stats_table[0])) - 1)
+
+/* Values of the counters at the last reset, and at the last snapshot. */
+static intmax_t stats_base[NSTATS];
+static intmax_t stats_values[NSTATS];
+
+static intmax_t
+stats_raw (int i)
+{
+  STATS_ENTRY *s;
+
+  s = stats_table + i;
+#if defined (MALLOC_DEBUG) && defined (USING_BASH_MALLOC)
+  if (s->uvalue == &malloc_bytesused)
+    malloc_bytesused = malloc_stats ().bytesused;
+#endif
+  return (s->ivalue ? *s->ivalue : (intmax_t)*s->uvalue);
+}
+
+/* Return the name of the Ith counter, or NULL if there are fewer. */
+const char *
+stats_name (int i)
+{
+  return ((i >= 0 && i < NSTATS) ? stats_table[i].name : (char *)NULL);
+}
+
+/* Record the current value of every counter, so that building the
+   BASH_STATS table doesn't change the numbers it reports. */
+void
+stats_snapshot (void)
+{
+  int i;
+
+  for (i = 0; i < NSTATS; i++)
+    stats_values[i] = stats_raw (i) - stats_base[i];
+}
+
+/* Return the value of the Ith counter at the last snapshot. */
+intmax_t
+stats_value (int i)
+{
+  return ((i >= 0 && i < NSTATS) ? stats_values[i] : 0);
+}
+
+/* Start all the counters over from zero.  The counters themselves keep
+   counting, since the profiler takes differences between them. */
+void
+stats_reset (void)
+{
+  int i;
+
+  for (i = 0; i < NSTATS; i++)
+    if ((stats_table[i].flags & STATS_GAUGE) == 0)
+      stats_base[i] = stats_raw (i);
+}
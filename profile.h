@@ -0,0 +1,65 @@
+/* profile.h -- declarations for the shell function profiler. */
+
+/* Copyright (C) 2024 Free Software Foundation, Inc.
+
+   This file is part of GNU Bash, the Bourne Again SHell.
+
+   Bash is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Bash is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Bash.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if !defined (_PROFILE_H_)
+#define _PROFILE_H_
+
+#include "stdc.h"
+
+/* Counters of the work the shell does, reported through BASH_STATS.  They
+   are only ever incremented; resetting BASH_STATS records their current
+   values as a new baseline. */
+struct shell_stats {
+  intmax_t forks;		/* successful fork()s in make_child */
+  intmax_t fork_retries;	/* fork() failed with EAGAIN and was retried */
+  intmax_t fork_failures;	/* make_child gave up */
+  intmax_t execs;		/* disk commands the shell started */
+  intmax_t subshells;		/* (...) and forked compound commands */
+  intmax_t comsubs;		/* forked command substitutions */
+  intmax_t procsubs;		/* process substitutions */
+  intmax_t var_lookups;		/* find_variable and friends */
+  intmax_t globs;		/* words expanded as filename patterns */
+  intmax_t history_adds;
+  intmax_t history_reads;
+  intmax_t history_writes;
+};
+
+extern struct shell_stats shell_stats;
+
+/* Non-zero while BASH_PROFILE names a file.  Everything that calls into
+   the profiler tests this first, so it costs one branch when disabled. */
+extern int profiling_enabled;
+
+/* Functions from profile.c */
+extern void profile_start (const char *);
+extern void profile_stop (void);
+
+extern int profile_enter (const char *);
+extern void profile_leave (int);
+
+extern int profile_line_start (int, const char *);
+extern void profile_line_end (int);
+
+extern const char *stats_name (int);
+extern void stats_snapshot (void);
+extern intmax_t stats_value (int);
+extern void stats_reset (void);
+
+#endif /* _PROFILE_H_ */
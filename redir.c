@@ -890,6 +890,11 @@ do_redirection_internal (REDIRECT *redirect, int flags, char **fnp)
 
   fdactive = 0;
 
+  /* Buffered trace output belongs to the trace file descriptor as it is
+     now, not to whatever this redirection makes it. */
+  if ((flags & RX_ACTIVE) && (rflags & REDIR_VARASSIGN) == 0)
+    xtrace_fdflush (redirector);
+
   switch (ri)
     {
     case r_output_direction:
@@ -1033,6 +1038,7 @@ do_redirection_internal (REDIRECT *redirect, int flags, char **fnp)
 	    {
 	      if (flags & RX_UNDOABLE)
 		add_undo_redirect (2, ri, -1);
+	      xtrace_fdflush (2);
 	      if (dup2 (1, 2) < 0)
 		return (errno);
 	    }
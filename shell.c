@@ -69,6 +69,7 @@ extern int get_tty_state (void);
 #include "input.h"
 #include "execute_cmd.h"
 #include "findcmd.h"
+#include "profile.h"
 
 #if defined (USING_BASH_MALLOC) && defined (DEBUG) && !defined (DISABLE_MALLOC_WRAPPERS)
 #  include <malloc/shmalloc.h>
@@ -1000,6 +1001,9 @@ exit_shell (int s)
   if (signal_is_trapped (0))
     s = run_exit_trap ();
 
+  if (profiling_enabled)
+    profile_stop ();
+
 #if defined (PROCESS_SUBSTITUTION)
   unlink_all_fifos ();
 #endif /* PROCESS_SUBSTITUTION */
@@ -58,6 +58,7 @@
 #include "trap.h"
 #include "pathexp.h"
 #include "mailcheck.h"
+#include "profile.h"
 
 #include "shmbutil.h"
 #if defined (HAVE_MBSTR_H) && defined (HAVE_MBSCHR)
@@ -169,6 +170,22 @@ size_t ifs_firstc_len;
 unsigned char ifs_firstc;
 #endif
 
+/* A byte-class table used to split a string on the characters in a set of
+   separators without decoding each character.  MAP is non-zero for bytes
+   that end a field (IFS_SEPBYTE) or that may begin a CTLESC-quoted
+   sequence (IFS_ESCBYTE).  If there are few enough such bytes, STOPS lists
+   them so the scanner can search for them a word at a time. */
+#define IFS_SEPBYTE	0x01
+#define IFS_ESCBYTE	0x02
+
+#define IFS_MAXSTOPS	4
+
+typedef struct ifs_splitmap {
+  unsigned char map[UCHAR_MAX + 1];
+  unsigned char stops[IFS_MAXSTOPS];
+  int nstops;		/* 0 means scan using MAP a byte at a time */
+} IFS_SPLITMAP;
+
 /* If non-zero, command substitution inherits the value of errexit option */
 int inherit_errexit = 0;
 
@@ -269,7 +286,9 @@ static SHELL_VAR *do_compound_assignment (const char *, char *, int);
 #endif
 static int do_assignment_internal (const WORD_DESC *, int);
 
-static char *string_extract_verbatim (const char *, size_t, size_t *, char *, int);
+static int ifs_splitmap_init (IFS_SPLITMAP *, const char *, int);
+static size_t ifs_splitspan (const char *, size_t, const IFS_SPLITMAP *);
+static char *string_extract_verbatim (const char *, size_t, size_t *, char *, const IFS_SPLITMAP *, int);
 static char *string_extract (const char *, size_t *, const char *, int);
 static char *string_extract_double_quoted (const char *, size_t *, int);
 static inline char *string_extract_single_quoted (const char *, size_t *, int);
@@ -762,6 +781,40 @@ sub_append_string (char *source, char *target, size_t *indx, size_t *size)
   return (target);
 }
 
+/* Append SOURCE to TARGET at INDX, quoted as quote_string would quote it,
+   without making a quoted copy first.  INDX and SIZE are as in
+   SUB_APPEND_STRING.  SOURCE is not freed. */
+static char *
+sub_append_quoted (const char *source, char *target, size_t *indx, size_t *size)
+{
+  size_t slen, n;
+  const char *send;
+  char *t;
+  DECLARE_MBSTATE;
+
+  slen = strlen (source);
+  n = (slen ? slen * 2 : 1) + *indx;
+  if (n >= *size)
+    {
+      n = (n + DEFAULT_ARRAY_SIZE) - (n % DEFAULT_ARRAY_SIZE);
+      target = (char *)xrealloc (target, (*size = n));
+    }
+
+  t = target + *indx;
+  if (slen == 0)
+    *t++ = CTLNUL;
+  else
+    for (send = source + slen; source < send; )
+      {
+	*t++ = CTLESC;
+	COPY_CHAR_P (t, source, send);
+      }
+  *t = '\0';
+  *indx = t - target;
+
+  return (target);
+}
+
 #if 0
 /* UNUSED */
 /* Append the textual representation of NUMBER to TARGET.
@@ -1140,10 +1193,80 @@ skip_single_quoted (const char *string, size_t slen, size_t sind, int flags)
   return si;
 }
 
+/* Fill in SMAP to split strings on the characters in SEPARATORS, with
+   FLAGS being the SX_ flags that will be passed to string_extract_verbatim.
+   Returns 0 if the current locale requires that the string be decoded
+   character by character: separator bytes can only be recognized directly
+   in single-byte locales and when they are 7-bit characters in UTF-8. */
+static int
+ifs_splitmap_init (IFS_SPLITMAP *smap, const char *separators, int flags)
+{
+  const unsigned char *s;
+  int c, n;
+
+#if defined (HANDLE_MULTIBYTE)
+  if (locale_mb_cur_max > 1 &&
+	(locale_utf8locale == 0 || separators[mbsasciispan (separators)]))
+    return 0;
+#endif
+
+  memset (smap->map, 0, sizeof (smap->map));
+  for (s = (const unsigned char *)separators; *s; s++)
+    smap->map[*s] = IFS_SEPBYTE;
+  if ((flags & SX_NOCTLESC) == 0 || (flags & SX_NOESCCTLNUL) == 0)
+    smap->map[CTLESC] |= IFS_ESCBYTE;
+
+  for (c = 1, n = 0; c <= UCHAR_MAX; c++)
+    if (smap->map[c] && n++ < IFS_MAXSTOPS)
+      smap->stops[n - 1] = c;
+  smap->nstops = (n <= IFS_MAXSTOPS) ? n : 0;
+
+  return 1;
+}
+
+/* Word-at-a-time search for bytes: a word W contains the byte B if
+   IFS_HASBYTE(W, B * IFS_ONES) is non-zero. */
+#define IFS_ONES	((unsigned long)-1 / 0xff)
+#define IFS_HIGHS	(IFS_ONES << 7)
+#define IFS_HASBYTE(w, bw) \
+	((((w) ^ (bw)) - IFS_ONES) & ~((w) ^ (bw)) & IFS_HIGHS)
+
+/* Return the number of bytes at the start of S, which is LEN bytes long,
+   that are not special according to SMAP. */
+static size_t
+ifs_splitspan (const char *s, size_t len, const IFS_SPLITMAP *smap)
+{
+  unsigned long w, found, bw[IFS_MAXSTOPS];
+  size_t i;
+  int k;
+
+  i = 0;
+  if (smap->nstops > 0)
+    {
+      for (k = 0; k < smap->nstops; k++)
+	bw[k] = smap->stops[k] * IFS_ONES;
+      for ( ; i + sizeof (w) <= len; i += sizeof (w))
+	{
+	  memcpy (&w, s + i, sizeof (w));
+	  for (found = 0, k = 0; k < smap->nstops; k++)
+	    found |= IFS_HASBYTE (w, bw[k]);
+	  if (found)
+	    break;
+	}
+    }
+
+  /* Find the special byte in the word, or finish the string */
+  while (i < len && smap->map[(unsigned char)s[i]] == 0)
+    i++;
+  return i;
+}
+
 /* Just like string_extract, but doesn't hack backslashes or any of
-   that other stuff.  Obeys CTLESC quoting.  Used to do splitting on $IFS. */
+   that other stuff.  Obeys CTLESC quoting.  Used to do splitting on $IFS.
+   If SMAP is non-null, it was initialized from CHARLIST and FLAGS by
+   ifs_splitmap_init, and we use it to find the end of the field. */
 static char *
-string_extract_verbatim (const char *string, size_t slen, size_t *sindex, char *charlist, int flags)
+string_extract_verbatim (const char *string, size_t slen, size_t *sindex, char *charlist, const IFS_SPLITMAP *smap, int flags)
 {
   size_t i, c;
 #if defined (HANDLE_MULTIBYTE)
@@ -1174,6 +1297,36 @@ string_extract_verbatim (const char *string, size_t slen, size_t *sindex, char *
     }
 
   i = *sindex;
+
+  if (smap)
+    {
+      while (i < slen)
+	{
+	  i += ifs_splitspan (string + i, slen - i, smap);
+	  if (i >= slen)
+	    break;
+	  c = (unsigned char)string[i];
+	  /* CTLESC quotes the next byte; in UTF-8 locales, any remaining
+	     bytes of a quoted multibyte character are never special. */
+	  if ((smap->map[c] & IFS_ESCBYTE) &&
+		((flags & SX_NOCTLESC) == 0 || string[i+1] == CTLNUL))
+	    {
+	      i += 2;
+	      continue;
+	    }
+	  if (smap->map[c] & IFS_SEPBYTE)
+	    break;
+	  i++;
+	}
+      if (i > slen)
+	i = slen;
+
+      temp = substring (string, *sindex, i);
+      *sindex = i;
+
+      return (temp);
+    }
+
 #if defined (HANDLE_MULTIBYTE)
   wcharlist = 0;
 #endif
@@ -3113,15 +3266,30 @@ string_list_pos_params (int pchar, WORD_LIST *list, int quoted, int pflags)
 #define ifs_whitesep(c)	((sh_style_split || separators == 0) ? spctabnl (c) \
 							     : ifs_whitespace (c))
 
+/* Add W to the end of the list of fields being built by list_string */
+#define ADD_SPLIT_WORD(w) \
+  do \
+    { \
+      WORD_LIST *_nl; \
+      _nl = make_word_list ((w), (WORD_LIST *)NULL); \
+      if (tail) \
+	tail->next = _nl; \
+      else \
+	result = _nl; \
+      tail = _nl; \
+    } \
+  while (0)
+
 WORD_LIST *
 list_string (char *string, char *separators, int quoted)
 {
-  WORD_LIST *result;
+  WORD_LIST *result, *tail;
   WORD_DESC *t;
   char *current_word, *s;
   int sh_style_split, whitesep, xflags, free_word;
   size_t sindex;
   size_t slen;
+  IFS_SPLITMAP splitmap, *smap;
 
   if (!string || !*string)
     return ((WORD_LIST *)NULL);
@@ -3161,12 +3329,14 @@ list_string (char *string, char *separators, int quoted)
 	skip sequences of whitespace characters as long as they are separators
      This obeys the field splitting rules in Posix.2. */
   slen = STRLEN (string);
-  result = NULL;
+  /* Find field ends using a byte-class table when the locale allows it. */
+  smap = (separators && *separators && ifs_splitmap_init (&splitmap, separators, xflags)) ? &splitmap : (IFS_SPLITMAP *)NULL;
+  result = tail = NULL;
   for (sindex = 0; sindex < slen; )
     {
       /* Don't need string length in ADVANCE_CHAR unless multibyte chars are
 	 possible, but need it in string_extract_verbatim for bounds checking */
-      current_word = string_extract_verbatim (string, slen, &sindex, separators, xflags);
+      current_word = string_extract_verbatim (string, slen, &sindex, separators, smap, xflags);
       if (current_word == 0)
 	break;
 
@@ -3181,7 +3351,7 @@ list_string (char *string, char *separators, int quoted)
 	  t = alloc_word_desc ();
 	  t->word = make_quoted_char ('\0');
 	  t->flags |= W_QUOTED|W_HASQUOTEDNULL;
-	  result = make_word_list (t, result);
+	  ADD_SPLIT_WORD (t);
 	}
       else if (current_word[0] != '\0')
 	{
@@ -3195,15 +3365,15 @@ list_string (char *string, char *separators, int quoted)
 	     free it), and skip all of make_word. */
 	  t = alloc_word_desc ();
 	  t->word = current_word;
-	  result = make_word_list (t, result);
+	  ADD_SPLIT_WORD (t);
 	  free_word = 0;
-	  result->word->flags &= ~W_HASQUOTEDNULL;	/* just to be sure */
+	  t->flags &= ~W_HASQUOTEDNULL;	/* just to be sure */
 	  if (quoted & (Q_DOUBLE_QUOTES|Q_HERE_DOCUMENT))
-	    result->word->flags |= W_QUOTED;
+	    t->flags |= W_QUOTED;
 	  /* If removing quoted null characters leaves an empty word, note
 	     that we saw this for the caller to act on. */
 	  if (current_word == 0 || current_word[0] == '\0')
-	    result->word->flags |= W_SAWQUOTEDNULL;
+	    t->flags |= W_SAWQUOTEDNULL;
 	}
 
       /* If we're not doing sequences of separators in the traditional
@@ -3213,7 +3383,7 @@ list_string (char *string, char *separators, int quoted)
 	  t = alloc_word_desc ();
 	  t->word = make_quoted_char ('\0');
 	  t->flags |= W_QUOTED|W_HASQUOTEDNULL;
-	  result = make_word_list (t, result);
+	  ADD_SPLIT_WORD (t);
 	}
 
       if (free_word)
@@ -3247,7 +3417,7 @@ list_string (char *string, char *separators, int quoted)
 	    sindex++;
 	}
     }
-  return (REVERSE_LIST (result, WORD_LIST *));
+  return (result);
 }
 
 /* Parse a single word from STRING, using SEPARATORS to separate fields.
@@ -3317,7 +3487,7 @@ get_word_from_string (char **stringp, char *separators, char **endptr)
   /* Don't need string length in ADVANCE_CHAR unless multibyte chars are
      possible, but need it in string_extract_verbatim for bounds checking */
   slen = STRLEN (s);
-  current_word = string_extract_verbatim (s, slen, &sindex, separators, xflags);
+  current_word = string_extract_verbatim (s, slen, &sindex, separators, (IFS_SPLITMAP *)NULL, xflags);
 
   /* Set ENDPTR to the first character after the end of the word. */
   if (endptr)
@@ -4841,6 +5011,38 @@ dequote_string (const char *string)
   return (result);
 }
 
+/* De-quote quoted characters in STRING in place.  The result is never
+   longer than STRING, so word-list dequoting can reuse the word's storage
+   instead of allocating a copy.  Return STRING. */
+static char *
+dequote_string_inplace (char *string)
+{
+  char *s, *t;
+  const char *send;
+  DECLARE_MBSTATE;
+
+  if (QUOTED_NULL (string))
+    {
+      string[0] = '\0';
+      return (string);
+    }
+
+  if ((s = strchr (string, CTLESC)) == NULL)
+    return (string);
+
+  send = s + strlen (s);
+  t = s;
+  while (*s)
+    {
+      if (*s == CTLESC && s[1])		/* don't drop trailing CTLESC */
+	s++;
+      COPY_CHAR_P (t, s, send);
+    }
+
+  *t = '\0';
+  return (string);
+}
+
 /* Quote the entire WORD_LIST list. */
 static WORD_LIST *
 quote_list (WORD_LIST *list)
@@ -4878,16 +5080,13 @@ dequote_word (WORD_DESC *word)
 WORD_LIST *
 dequote_list (WORD_LIST *list)
 {
-  char *s;
   WORD_LIST *tlist;
 
   for (tlist = list; tlist; tlist = tlist->next)
     {
-      s = dequote_string (tlist->word->word);
       if (QUOTED_NULL (tlist->word->word))
 	tlist->word->flags &= ~W_HASQUOTEDNULL;
-      free (tlist->word->word);
-      tlist->word->word = s;
+      dequote_string_inplace (tlist->word->word);
       tlist->word->flags &= ~W_QUOTED;		/* no longer quoted */
     }
   return list;
@@ -5272,8 +5471,13 @@ remove_pattern (char *param, char *pattern, int op)
       wchar_t *wparam, *wpattern;
       mbstate_t ps;
 
-      /* XXX - could optimize here by checking param and pattern for multibyte
-	 chars with mbsmbchar and calling remove_upattern. */
+      /* Strings without multibyte characters don't need to be converted
+	 to wide characters to be matched, as in match_pattern. */
+      if (mbsmbchar (param) == 0 && mbsmbchar (pattern) == 0)
+	{
+	  xret = remove_upattern (param, pattern, op);
+	  return ((xret == param) ? savestring (param) : xret);
+	}
 
       n = xdupmbstowcs (&wpattern, NULL, pattern);
       if (n == (size_t)-1)
@@ -6407,6 +6611,7 @@ process_substitute (char *string, int open_for_read_in_child)
   save_pipeline (1);
 #endif /* JOB_CONTROL */
 
+  shell_stats.procsubs++;
   pid = make_child ((char *)NULL, FORK_ASYNC|FORK_PROCSUB);
   if (pid == 0)
     {
@@ -7248,6 +7453,7 @@ command_substitute (char *string, int quoted, int flags)
 
   old_async_pid = last_asynchronous_pid;
   fork_flags = (subshell_environment&SUBSHELL_ASYNC) ? FORK_ASYNC : 0;
+  shell_stats.comsubs++;
   pid = make_child ((char *)NULL, fork_flags|FORK_NOTERM|FORK_COMSUB);
   last_asynchronous_pid = old_async_pid;
 
@@ -9023,6 +9229,24 @@ mb_substring (const char *string, int s, int e)
   /* Don't need string length in ADVANCE_CHAR unless multibyte chars possible. */
   slen = (locale_mb_cur_max > 1) ? STRLEN (string) : 0;
 
+  if (locale_mb_cur_max > 1 && locale_shiftstates == 0)
+    {
+      /* Character positions are byte offsets in strings of 7-bit
+	 characters. */
+      if (mbsasciispan (string) == slen)
+	{
+	  start = (s < slen) ? s : slen;
+	  stop = (e < slen) ? e : slen;
+	  return (substring (string, start, stop));
+	}
+      if (locale_utf8locale)
+	{
+	  start = utf8_mbsadvance (string, slen, 0, s);
+	  stop = utf8_mbsadvance (string, slen, start, e - s);
+	  return (substring (string, start, stop));
+	}
+    }
+
   i = s;
   while (string[start] && i--)
     ADVANCE_CHAR (string, slen, start);
@@ -11334,10 +11558,14 @@ expand_word_internal (WORD_DESC *word, int quoted, int isexp, int *contains_doll
 	  else
 #endif
 	    {
-	      temp = (char *)xmalloc (3);
-	      temp[0] = CTLESC;
-	      temp[1] = c = string[sindex];
-	      temp[2] = '\0';
+	      /* Add the quoted character directly instead of making a
+		 two-character string to append. */
+	      RESIZE_MALLOCED_BUFFER (istring, istring_index, 2, istring_size, DEFAULT_ARRAY_SIZE);
+	      istring[istring_index++] = CTLESC;
+	      if (c = string[sindex])
+		istring[istring_index++] = c;
+	      istring[istring_index] = '\0';
+	      temp = (char *)NULL;
 	    }
 
 dollar_add_string:
@@ -11801,7 +12029,9 @@ add_twochars:
 		}
 	      else
 		{
-		  temp = savestring (list->word->word);
+		  /* Take the word from the list instead of copying it. */
+		  temp = list->word->word;
+		  list->word->word = (char *)NULL;
 		  tflag = list->word->flags;
 		  dispose_words (list);
 
@@ -11856,9 +12086,9 @@ add_twochars:
 
 	  if (temp)
 	    {
-	      temp1 = temp;
-	      temp = quote_string (temp);
-	      free (temp1);
+	      istring = sub_append_quoted (temp, istring, &istring_index, &istring_size);
+	      free (temp);
+	      temp = (char *)NULL;
 	      goto add_string;
 	    }
 	  else
@@ -12586,7 +12816,7 @@ expand_words_shellexp (WORD_LIST *list)
 static WORD_LIST *
 glob_expand_word_list (WORD_LIST *tlist, int eflags)
 {
-  char **glob_array, *temp_string;
+  char **glob_array;
   register int glob_index;
   WORD_LIST *glob_list, *output_list, *disposables, *next;
   WORD_DESC *tword;
@@ -12629,9 +12859,7 @@ glob_expand_word_list (WORD_LIST *tlist, int eflags)
 	  /* Dequote the current word in case we have to use it. */
 	  if (glob_array[0] == NULL)
 	    {
-	      temp_string = dequote_string (tlist->word->word);
-	      free (tlist->word->word);
-	      tlist->word->word = temp_string;
+	      dequote_string_inplace (tlist->word->word);
 	    }
 
 	  /* Make the array into a word list. */
@@ -12667,9 +12895,7 @@ glob_expand_word_list (WORD_LIST *tlist, int eflags)
       else
 	{
 	  /* Dequote the string. */
-	  temp_string = dequote_string (tlist->word->word);
-	  free (tlist->word->word);
-	  tlist->word->word = temp_string;
+	  dequote_string_inplace (tlist->word->word);
 	  PREPEND_LIST (tlist, output_list);
 	}
 
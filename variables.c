@@ -57,6 +57,7 @@
 #include "hashcmd.h"
 #include "pathexp.h"
 #include "alias.h"
+#include "profile.h"
 #include "jobs.h"
 
 #include "builtins/getopt.h"
@@ -106,6 +107,18 @@
 #define FV_SKIPINVISIBLE	0x02
 #define FV_NODYNAMIC		0x04
 
+/* Number of variables allocated at a time from the variable pool. */
+#define VARPOOL_CHUNK		64
+
+/* SHELL_VAR structures come from a pool, since local variables and
+   temporary environments create and dispose of them constantly.  Use
+   new_shell_variable and dispose_variable rather than allocating or
+   freeing them directly. */
+sh_obj_pool_t varpool = OPOOL_INITIALIZER (VARPOOL_CHUNK);
+
+#define varalloc(v)	opool_alloc (varpool, SHELL_VAR, v)
+#define varfree(v)	opool_free (varpool, SHELL_VAR, v)
+
 extern char **environ;
 
 /* Variables used here and defined in other files. */
@@ -171,6 +184,12 @@ int shell_level = 0;
 /* If non-zero, each element of BASH_SOURCE contains a full pathnames */
 int bash_source_fullpath = BASH_SOURCE_FULLPATH_DEFAULT;
 
+#if defined (FUNCTION_IMPORT)
+/* The parser options in effect when functions were imported from the
+   environment, used when they are parsed on first use. */
+static int import_extglob, import_posix, import_compat;
+#endif
+
 /* An array which is passed to commands as their environment.  It is
    manufactured from the union of the initial environment and the
    shell variables that are marked for export. */
@@ -178,6 +197,12 @@ char **export_env = (char **)NULL;
 static int export_env_index;
 static size_t export_env_size;
 
+/* An index on the names in EXPORT_ENV, built the first time an assignment
+   is superseded after the environment is remade.  Each slot holds an
+   export_env index plus one; zero is an empty slot. */
+static size_t *export_env_slots;
+static size_t export_env_nslots;	/* a power of two, or 0 if no index */
+
 #if defined (READLINE)
 static int winsize_assignment;		/* currently assigning to LINES or COLUMNS */
 #endif
@@ -263,6 +288,9 @@ static SHELL_VAR *get_bashargcv (SHELL_VAR *);
 static SHELL_VAR *build_hashcmd (SHELL_VAR *);
 static SHELL_VAR *get_hashcmd (SHELL_VAR *);
 static SHELL_VAR *assign_hashcmd (SHELL_VAR *, char *, arrayind_t, char *);
+static SHELL_VAR *build_statsvar (SHELL_VAR *);
+static SHELL_VAR *get_statsvar (SHELL_VAR *);
+static SHELL_VAR *assign_statsvar (SHELL_VAR *, char *, arrayind_t, char *);
 #  if defined (ALIAS)
 static SHELL_VAR *build_aliasvar (SHELL_VAR *);
 static SHELL_VAR *get_aliasvar (SHELL_VAR *);
@@ -276,11 +304,16 @@ static SHELL_VAR *init_funcname_var (void);
 static void initialize_dynamic_variables (void);
 
 static SHELL_VAR *bind_invalid_envvar (const char *, const char *, int);
+#if defined (FUNCTION_IMPORT)
+static SHELL_VAR *bind_function_stub (const char *, const char *);
+static SHELL_VAR *import_function (SHELL_VAR *);
+static void import_all_functions (void);
+static int unparsed_function (SHELL_VAR *);
+#endif
 
 static int var_sametype (SHELL_VAR *, SHELL_VAR *);
 
 static SHELL_VAR *hash_lookup (const char *, HASH_TABLE *);
-static SHELL_VAR *new_shell_variable (const char *);
 static SHELL_VAR *make_new_variable (const char *, HASH_TABLE *);
 static SHELL_VAR *bind_variable_internal (const char *, const char *, HASH_TABLE *, int, int);
 
@@ -291,11 +324,14 @@ static void free_variable_hash_data (PTR_T);
 
 static VARLIST *vlist_alloc (size_t);
 static VARLIST *vlist_realloc (VARLIST *, size_t);
+static void vlist_index_insert (VARLIST *, size_t);
+static void vlist_index (VARLIST *);
 static void vlist_add (VARLIST *, SHELL_VAR *, int);
+static SHELL_VAR **vlist_dispose (VARLIST *);
 
 static void flatten (HASH_TABLE *, sh_var_map_func_t *, VARLIST *, int);
 
-static int qsort_var_comp (SHELL_VAR **, SHELL_VAR **);
+static const char *sort_var_key (void *);
 
 static SHELL_VAR **vapply (sh_var_map_func_t *);
 static SHELL_VAR **fapply (sh_var_map_func_t *);
@@ -410,24 +446,13 @@ initialize_shell_variables (char **env, int privmode)
 	  tname = name + BASHFUNC_PREFLEN;	/* start of func name */
 	  tname[namelen] = '\0';		/* now tname == func name */
 
-	  string_length = strlen (string);
-	  temp_string = (char *)xmalloc (namelen + string_length + 2);
-
-	  memcpy (temp_string, tname, namelen);
-	  temp_string[namelen] = ' ';
-	  memcpy (temp_string + namelen + 1, string, string_length + 1);
-
 	  /* Don't import function names that are invalid identifiers from the
 	     environment in posix mode, though we still allow them to be defined as
-	     shell variables. */
+	     shell variables.  The definition itself is checked and parsed the
+	     first time the function is looked up; see import_function. */
 	  if (absolute_program (tname) == 0 && (posixly_correct == 0 || valid_identifier (tname)))
-	    parse_and_execute (temp_string, tname, SEVAL_NONINT|SEVAL_NOHIST|SEVAL_FUNCDEF|SEVAL_ONECMD);
-	  else
-	    free (temp_string);		/* parse_and_execute does this */
-
-	  if (temp_var = find_function (tname))
 	    {
-	      VSETATTR (temp_var, (att_exported|att_imported));
+	      temp_var = bind_function_stub (tname, string);
 	      array_needs_making = 1;
 	    }
 	  else
@@ -530,8 +555,9 @@ initialize_shell_variables (char **env, int privmode)
 
       name[char_index] = '=';
       /* temp_var can be NULL if it was an exported function with a syntax
-	 error (a different bug, but it still shouldn't dump core). */
-      if (temp_var && function_p (temp_var) == 0)	/* XXX not yet */
+	 error (a different bug, but it still shouldn't dump core).  Imported
+	 functions already have the import string as their export text. */
+      if (temp_var && function_p (temp_var) == 0)
 	{
 	  CACHE_IMPORTSTR (temp_var, name);
 	}
@@ -700,6 +726,21 @@ initialize_shell_variables (char **env, int privmode)
   if (temp_var && imported_p (temp_var))
     sv_xtracefd (temp_var->name);
 
+  temp_var = find_variable ("BASH_XTRACEOPTS");
+  if (temp_var && imported_p (temp_var))
+    sv_xtraceopts (temp_var->name);
+
+  /* Like BASH_ENV, BASH_PROFILE is ignored in privileged mode.  Don't
+     pass it on, so the shells this one runs don't overwrite its report. */
+  temp_var = find_variable ("BASH_PROFILE");
+  if (temp_var && imported_p (temp_var) && exported_p (temp_var))
+    {
+      VUNSETATTR (temp_var, att_exported);
+      array_needs_making = 1;
+      if (privmode == 0)
+	sv_bash_profile (temp_var->name);
+    }
+
   sv_shcompat ("BASH_COMPAT");
 
   /* Allow FUNCNEST to be inherited from the environment. */
@@ -1740,6 +1781,46 @@ assign_hashcmd (SHELL_VAR *self, char *value, arrayind_t ind, char *key)
   return (build_hashcmd (self));
 }
 
+static SHELL_VAR *
+build_statsvar (SHELL_VAR *self)
+{
+  HASH_TABLE *h;
+  int i;
+  const char *name;
+  char *k, *v, ibuf[INT_STRLEN_BOUND (intmax_t) + 1];
+
+  h = assoc_cell (self);
+  if (h)
+    assoc_dispose (h);
+
+  stats_snapshot ();
+  h = assoc_create (0);
+  for (i = 0; (name = stats_name (i)); i++)
+    {
+      k = savestring (name);
+      v = inttostr (stats_value (i), ibuf, sizeof (ibuf));
+      assoc_insert (h, k, v);
+    }
+
+  var_setvalue (self, (char *)h);
+  return self;
+}
+
+static SHELL_VAR *
+get_statsvar (SHELL_VAR *self)
+{
+  build_statsvar (self);
+  return (self);
+}
+
+/* Assigning to any element of BASH_STATS starts the counters over. */
+static SHELL_VAR *
+assign_statsvar (SHELL_VAR *self, char *value, arrayind_t ind, char *key)
+{
+  stats_reset ();
+  return (build_statsvar (self));
+}
+
 #if defined (ALIAS)
 static SHELL_VAR *
 build_aliasvar (SHELL_VAR *self)
@@ -1893,6 +1974,7 @@ initialize_dynamic_variables (void)
   v = init_dynamic_array_var ("BASH_LINENO", get_self, null_array_assign, att_noassign|att_nounset);
 
   v = init_dynamic_assoc_var ("BASH_CMDS", get_hashcmd, assign_hashcmd, att_nofree);
+  v = init_dynamic_assoc_var ("BASH_STATS", get_statsvar, assign_statsvar, att_nofree);
 #  if defined (ALIAS)
   v = init_dynamic_assoc_var ("BASH_ALIASES", get_aliasvar, assign_aliasvar, att_nofree);
 #  endif
@@ -1967,6 +2049,7 @@ find_variable_internal (const char *name, int flags)
   VAR_CONTEXT *vc;
 
   var = (SHELL_VAR *)NULL;
+  shell_stats.var_lookups++;
 
   force_tempenv = (flags & FV_FORCETEMPENV);
 
@@ -2453,10 +2536,161 @@ find_variable_noref (const char *name)
    Returns the entry or NULL. */
 SHELL_VAR *
 find_function (const char *name)
+{
+  SHELL_VAR *func;
+
+  func = hash_lookup (name, shell_functions);
+#if defined (FUNCTION_IMPORT)
+  if (func && unparsed_p (func))
+    func = import_function (func);
+#endif
+  return (func);
+}
+
+/* Look up the function entry whose name matches STRING without parsing
+   it if it was imported from the environment and hasn't been used yet,
+   for callers that are about to remove or replace it.  Such a function
+   has no definition yet, and can't be readonly. */
+SHELL_VAR *
+find_function_noimport (const char *name)
 {
   return (hash_lookup (name, shell_functions));
 }
 
+#if defined (FUNCTION_IMPORT)
+/* Parse the definition of FUNC, a function imported from the environment
+   whose import string is still its only definition.  The definition gets
+   the same checks it would have had at startup: it must be a single
+   definition of a function with FUNC's name and nothing after it, and it
+   is parsed with the options in effect when the shell read its environment
+   and without aliases.  Returns the function, or NULL if the definition is
+   rejected, in which case the import string stays in the environment as an
+   invalid variable, as it would have if the shell had parsed it at
+   startup. */
+static SHELL_VAR *
+import_function (SHELL_VAR *func)
+{
+  char *envstr, *name, *string, *temp_string;
+  size_t namelen, string_length;
+  int old_exit_value, old_verbose, old_anm, old_line;
+  int old_expalias, old_extglob, old_posix, old_compat;
+  sh_builtin_func_t *old_builtin;
+  SHELL_VAR *temp_var;
+#if defined (DEBUGGER)
+  FUNCTION_DEF *def;
+#endif
+
+  /* The import string becomes the export text again if the definition is
+     accepted; clear the flag first so we don't try to import recursively. */
+  envstr = func->exportstr;
+  func->exportstr = (char *)NULL;
+  VUNSETATTR (func, att_unparsed);
+
+  name = savestring (func->name);
+  namelen = strlen (name);
+  string = envstr + BASHFUNC_PREFLEN + namelen + BASHFUNC_SUFFLEN + 1;
+  string_length = strlen (string);
+
+  temp_string = (char *)xmalloc (namelen + string_length + 2);
+  memcpy (temp_string, name, namelen);
+  temp_string[namelen] = ' ';
+  memcpy (temp_string + namelen + 1, string, string_length + 1);
+
+  /* Looking up a function should not change $? or echo its definition,
+     and the definition should mean what it would have meant at startup. */
+  old_exit_value = last_command_exit_value;
+  old_verbose = echo_input_at_read;
+  old_builtin = this_shell_builtin;
+  old_anm = array_needs_making;
+  old_line = line_number;
+  old_expalias = expand_aliases;
+  old_extglob = extended_glob;
+  old_posix = posixly_correct;
+  old_compat = shell_compatibility_level;
+
+  echo_input_at_read = 0;
+  this_shell_builtin = (sh_builtin_func_t *)NULL;
+  line_number = 0;
+  expand_aliases = 0;
+  extended_glob = import_extglob;
+  posixly_correct = import_posix;
+  shell_compatibility_level = import_compat;
+
+  parse_and_execute (temp_string, name, SEVAL_NONINT|SEVAL_NOHIST|SEVAL_FUNCDEF|SEVAL_ONECMD);
+
+  last_command_exit_value = old_exit_value;
+  echo_input_at_read = old_verbose;
+  this_shell_builtin = old_builtin;
+  line_number = old_line;
+  expand_aliases = old_expalias;
+  extended_glob = old_extglob;
+  posixly_correct = old_posix;
+  shell_compatibility_level = old_compat;
+
+  func = hash_lookup (name, shell_functions);
+  if (func && function_cell (func))
+    {
+      /* The exported text is unchanged, so the environment is too. */
+      INVALIDATE_EXPORTSTR (func);
+      func->exportstr = envstr;
+      VSETATTR (func, (att_exported|att_imported));
+      array_needs_making = old_anm;
+#if defined (DEBUGGER)
+      /* The definition comes from the environment, wherever it's used. */
+      if (def = find_function_def (name))
+	{
+	  FREE (def->source_file);
+	  def->source_file = savestring ("environment");
+	}
+#endif
+    }
+  else
+    {
+      if (func)
+	unbind_func (name);
+      envstr[BASHFUNC_PREFLEN + namelen] = '\0';
+      temp_var = bind_invalid_envvar (envstr, string, 0);
+      envstr[BASHFUNC_PREFLEN + namelen] = BASHFUNC_SUFFIX[0];
+      if (temp_var)
+	{
+	  VSETATTR (temp_var, (att_exported | att_imported | att_invisible));
+	  INVALIDATE_EXPORTSTR (temp_var);
+	  temp_var->exportstr = envstr;
+	}
+      else
+	free (envstr);
+      array_needs_making = 1;
+      report_error (_("error importing function definition for `%s'"), name);
+      func = (SHELL_VAR *)NULL;
+    }
+
+  free (name);
+  return (func);
+}
+
+static int
+unparsed_function (SHELL_VAR *func)
+{
+  return (unparsed_p (func) != 0);
+}
+
+/* Parse the definitions of all imported functions that have not been
+   looked up yet, for callers that want every function's definition. */
+static void
+import_all_functions (void)
+{
+  SHELL_VAR **list;
+  register int i;
+
+  list = map_over_funcs (unparsed_function);
+  if (list == 0)
+    return;
+  for (i = 0; list[i]; i++)
+    import_function (list[i]);
+  free (list);
+}
+#endif /* FUNCTION_IMPORT */
+
 /* Find the function definition for the shell function named NAME.  Returns
    the entry or NULL. */
 FUNCTION_DEF *
@@ -2761,12 +2995,12 @@ init_variable (SHELL_VAR *entry)
 }
 
 /* Create a new shell variable with name NAME. */
-static SHELL_VAR *
+SHELL_VAR *
 new_shell_variable (const char *name)
 {
   SHELL_VAR *entry;
 
-  entry = (SHELL_VAR *)xmalloc (sizeof (SHELL_VAR));
+  varalloc (entry);
 
   entry->name = savestring (name);
   init_variable (entry);
@@ -3455,7 +3689,7 @@ bind_function (const char *name, COMMAND *value)
 {
   SHELL_VAR *entry;
 
-  entry = find_function (name);
+  entry = find_function_noimport (name);
   if (entry == 0)
     {
       BUCKET_CONTENTS *elt;
@@ -3465,7 +3699,10 @@ bind_function (const char *name, COMMAND *value)
       elt->data = (PTR_T)entry;
     }
   else
-    INVALIDATE_EXPORTSTR (entry);
+    {
+      INVALIDATE_EXPORTSTR (entry);
+      VUNSETATTR (entry, att_unparsed);
+    }
 
   if (var_isset (entry))
     dispose_command (function_cell (entry));
@@ -3492,6 +3729,28 @@ bind_function (const char *name, COMMAND *value)
   return (entry);
 }
 
+#if defined (FUNCTION_IMPORT)
+/* Bind NAME to a function imported from the environment with definition
+   VALUE, without parsing it.  The import string is the function's export
+   text until it is redefined; import_function parses it the first time
+   the function is looked up, with the options in effect now. */
+static SHELL_VAR *
+bind_function_stub (const char *name, const char *value)
+{
+  SHELL_VAR *entry;
+
+  entry = bind_function (name, (COMMAND *)NULL);
+  entry->exportstr = mk_env_string (name, value, att_function);
+  VSETATTR (entry, (att_exported|att_imported|att_unparsed));
+
+  import_extglob = extended_glob;
+  import_posix = posixly_correct;
+  import_compat = shell_compatibility_level;
+
+  return (entry);
+}
+#endif
+
 #if defined (DEBUGGER)
 /* Bind a function definition, which includes source file and line number
    information in addition to the command, into the FUNCTION_DEF hash table.
@@ -3665,7 +3924,7 @@ copy_variable (SHELL_VAR *var)
 
   if (var)
     {
-      copy = (SHELL_VAR *)xmalloc (sizeof (SHELL_VAR));
+      varalloc (copy);
 
       copy->attributes = var->attributes;
       copy->name = savestring (var->name);
@@ -3738,7 +3997,7 @@ dispose_variable (SHELL_VAR *var)
   if (exported_p (var))
     array_needs_making = 1;
 
-  free (var);
+  varfree (var);
 }
 
 /* placeholder function to work out the right semantics */
@@ -3900,8 +4159,7 @@ unbind_func (const char *name)
       dispose_variable (func);
     }
 
-  free (elt->key);
-  free (elt);
+  hash_dispose_item (elt);
 
   return 0;  
 }
@@ -3922,8 +4180,7 @@ unbind_function_def (const char *name)
   if (funcdef)
     dispose_function_def (funcdef);
 
-  free (elt->key);
-  free (elt);
+  hash_dispose_item (elt);
 
   return 0;  
 }
@@ -3944,8 +4201,7 @@ delete_var (const char *name, VAR_CONTEXT *vc)
     return (-1);
 
   old_var = (SHELL_VAR *)elt->data;
-  free (elt->key);
-  free (elt);
+  hash_dispose_item (elt);
 
   dispose_variable (old_var);
   return (0);
@@ -3999,8 +4255,7 @@ makunbound (const char *name, VAR_CONTEXT *vc)
       new_elt->data = (PTR_T)old_var;
       stupidly_hack_special_variables (old_var->name);
 
-      free (elt->key);
-      free (elt);
+      hash_dispose_item (elt);
       return (0);
     }
 
@@ -4009,8 +4264,7 @@ makunbound (const char *name, VAR_CONTEXT *vc)
      reference freed memory. */
   t = savestring (name);
 
-  free (elt->key);
-  free (elt);
+  hash_dispose_item (elt);
 
   dispose_variable (old_var);
   stupidly_hack_special_variables (t);
@@ -4136,10 +4390,49 @@ vlist_alloc (size_t nentries)
   vlist->list_size = nentries;
   vlist->list_len = 0;
   vlist->list[0] = (SHELL_VAR *)NULL;
+  vlist->index = (size_t *)NULL;
+  vlist->index_size = 0;
 
   return vlist;
 }
 
+/* Enter the variable at position N of VLIST->list into VLIST->index, an
+   open-addressed table of list positions plus one keyed on the variable
+   name.  A zero slot is empty. */
+static void
+vlist_index_insert (VARLIST *vlist, size_t n)
+{
+  size_t mask, h;
+
+  mask = vlist->index_size - 1;
+  for (h = hash_string (vlist->list[n]->name) & mask; vlist->index[h]; h = (h + 1) & mask)
+    ;
+  vlist->index[h] = n + 1;
+}
+
+/* Create or resize the name index for VLIST so it can hold the list's
+   allocated size at a load factor of at most one half.  Callers that
+   flatten more than one table use this so vlist_add can find names that
+   are already in the list without a linear search. */
+static void
+vlist_index (VARLIST *vlist)
+{
+  size_t nslots, i;
+
+  for (nslots = 16; nslots < 2 * (vlist->list_size + 1); nslots <<= 1)
+    ;
+  if (nslots <= vlist->index_size)
+    return;
+
+  FREE (vlist->index);
+  vlist->index = (size_t *)xmalloc (nslots * sizeof (size_t));
+  memset (vlist->index, 0, nslots * sizeof (size_t));
+  vlist->index_size = nslots;
+
+  for (i = 0; i < vlist->list_len; i++)
+    vlist_index_insert (vlist, i);
+}
+
 static VARLIST *
 vlist_realloc (VARLIST *vlist, size_t n)
 {
@@ -4149,26 +4442,46 @@ vlist_realloc (VARLIST *vlist, size_t n)
     {
       vlist->list_size = n;
       vlist->list = (SHELL_VAR **)xrealloc (vlist->list, (vlist->list_size + 1) * sizeof (SHELL_VAR *));
+      if (vlist->index)
+	vlist_index (vlist);
     }
   return vlist;
 }
 
+/* Add VAR to VLIST unless a variable with the same name is already there.
+   Only lists with an index are checked: names within a single hash table
+   are already unique. */
 static void
 vlist_add (VARLIST *vlist, SHELL_VAR *var, int flags)
 {
-  register int i;
+  size_t mask, h, i;
 
-  for (i = 0; i < vlist->list_len; i++)
-    if (STREQ (var->name, vlist->list[i]->name))
-      break;
-  if (i < vlist->list_len)
-    return;
+  if (vlist->index)
+    {
+      mask = vlist->index_size - 1;
+      for (h = hash_string (var->name) & mask; (i = vlist->index[h]); h = (h + 1) & mask)
+	if (STREQ (var->name, vlist->list[i - 1]->name))
+	  return;
+    }
 
-  if (i >= vlist->list_size)
+  if (vlist->list_len >= vlist->list_size)
     vlist = vlist_realloc (vlist, vlist->list_size + 16);
 
-  vlist->list[vlist->list_len++] = var;
-  vlist->list[vlist->list_len] = (SHELL_VAR *)NULL;
+  vlist->list[vlist->list_len] = var;
+  if (vlist->index)
+    vlist_index_insert (vlist, vlist->list_len);
+  vlist->list[++vlist->list_len] = (SHELL_VAR *)NULL;
+}
+
+static SHELL_VAR **
+vlist_dispose (VARLIST *vlist)
+{
+  SHELL_VAR **ret;
+
+  ret = vlist->list;
+  FREE (vlist->index);
+  free (vlist);
+  return ret;
 }
 
 /* Map FUNCTION over the variables in VAR_HASH_TABLE.  Return an array of the
@@ -4189,12 +4502,14 @@ map_over (sh_var_map_func_t *function, VAR_CONTEXT *vc)
     return (SHELL_VAR **)NULL;
 
   vlist = vlist_alloc (nentries);
+  /* Variables in inner contexts shadow those with the same name below. */
+  if (vc->down)
+    vlist_index (vlist);
 
   for (v = vc; v; v = v->down)
     flatten (v->table, function, vlist, 0);
 
-  ret = vlist->list;
-  free (vlist);
+  ret = vlist_dispose (vlist);
   return ret;
 }
 
@@ -4211,8 +4526,7 @@ map_over_funcs (sh_var_map_func_t *function)
 
   flatten (shell_functions, function, vlist, 0);
 
-  ret = vlist->list;
-  free (vlist);
+  ret = vlist_dispose (vlist);
   return ret;
 }
 
@@ -4246,21 +4560,17 @@ flatten (HASH_TABLE *var_hash_table, sh_var_map_func_t *func, VARLIST *vlist, in
     }
 }
 
-void
-sort_variables (SHELL_VAR **array)
+static const char *
+sort_var_key (void *var)
 {
-  qsort (array, strvec_len ((char **)array), sizeof (SHELL_VAR *), (QSFUNC *)qsort_var_comp);
+  return (((SHELL_VAR *)var)->name);
 }
 
-static int
-qsort_var_comp (SHELL_VAR **var1, SHELL_VAR **var2)
+/* Sort ARRAY bytewise by variable name. */
+void
+sort_variables (SHELL_VAR **array)
 {
-  int result;
-
-  if ((result = (*var1)->name[0] - (*var2)->name[0]) == 0)
-    result = strcmp ((*var1)->name, (*var2)->name);
-
-  return (result);
+  strvec_keysort ((void **)array, strvec_len ((char **)array), sort_var_key, 0);
 }
 
 /* Apply FUNC to each variable in SHELL_VARIABLES, adding each one for
@@ -4300,6 +4610,9 @@ all_shell_variables (void)
 SHELL_VAR **
 all_shell_functions (void)
 {
+#if defined (FUNCTION_IMPORT)
+  import_all_functions ();
+#endif
   return (fapply ((sh_var_map_func_t *)NULL));
 }
 
@@ -4397,8 +4710,7 @@ all_local_variables (int visible_only)
   else
     flatten (vc->table, variable_in_context, vlist, 0);
 
-  ret = vlist->list;
-  free (vlist);
+  ret = vlist_dispose (vlist);
   if (ret)
     sort_variables (ret);
   return ret;
@@ -4858,8 +5170,11 @@ make_env_array_from_var_list (SHELL_VAR **vars)
   for (i = 0, list_index = 0; var = vars[i]; i++)
     {
 #if defined (__CYGWIN__)
-      /* We don't use the exportstr stuff on Cygwin at all. */
-      INVALIDATE_EXPORTSTR (var);
+      /* We don't use the exportstr stuff on Cygwin at all, except for
+	 imported functions that haven't been parsed and have nothing else
+	 to export. */
+      if (unparsed_p (var) == 0)
+	INVALIDATE_EXPORTSTR (var);
 #endif
 
       /* If the value is generated dynamically, generate it here. */
@@ -4954,18 +5269,70 @@ make_func_export_array (void)
   return (list);
 }
 
-/* Add ENVSTR to the end of the exported environment, EXPORT_ENV. */
+/* Hash the name portion of the environment string S, up to the first
+   `=', using the same FNV-1 hash as hash_string. */
+static unsigned int
+export_env_hash (const char *s)
+{
+  register unsigned int i;
+
+  for (i = 2166136261U; *s && *s != '='; s++)
+    {
+      i += (i<<1) + (i<<4) + (i<<7) + (i<<8) + (i<<24);
+      i ^= *s;
+    }
+  return i;
+}
+
+static void
+export_env_slot_insert (int ind)
+{
+  size_t mask, h;
+
+  mask = export_env_nslots - 1;
+  for (h = export_env_hash (export_env[ind]) & mask; export_env_slots[h]; h = (h + 1) & mask)
+    ;
+  export_env_slots[h] = ind + 1;
+}
+
+/* (Re)build the name index for EXPORT_ENV with room for EXPORT_ENV_SIZE
+   entries at a load factor of at most one half. */
+static void
+export_env_make_index (void)
+{
+  size_t nslots;
+  int i;
+
+  for (nslots = 64; nslots < 2 * export_env_size; nslots <<= 1)
+    ;
+  if (nslots != export_env_nslots)
+    {
+      export_env_slots = (size_t *)xrealloc (export_env_slots, nslots * sizeof (size_t));
+      export_env_nslots = nslots;
+    }
+  memset (export_env_slots, 0, nslots * sizeof (size_t));
+
+  for (i = 0; i < export_env_index; i++)
+    export_env_slot_insert (i);
+}
+
+/* Add ENVSTR to the end of the exported environment, EXPORT_ENV.  The
+   array grows geometrically, and the name index, if any, is kept current. */
 #define add_to_export_env(envstr,do_alloc) \
 do \
   { \
     if (export_env_index >= (export_env_size - 1)) \
       { \
-	export_env_size += 16; \
+	export_env_size += export_env_size / 2 + 16; \
 	export_env = strvec_resize (export_env, export_env_size); \
 	environ = export_env; \
+	if (export_env_nslots) \
+	  export_env_make_index (); \
       } \
     export_env[export_env_index++] = (do_alloc) ? savestring (envstr) : envstr; \
     export_env[export_env_index] = (char *)NULL; \
+    if (export_env_nslots) \
+      export_env_slot_insert (export_env_index - 1); \
   } while (0)
 
 /* Add ASSIGN to EXPORT_ENV, or supersede a previous assignment in the
@@ -4973,8 +5340,8 @@ do \
 char **
 add_or_supercede_exported_var (char *assign, int do_alloc)
 {
-  register int i;
-  int equal_offset;
+  size_t mask, h, ind;
+  int i, equal_offset;
 
   equal_offset = assignment (assign, 0);
   if (equal_offset == 0)
@@ -4987,14 +5354,22 @@ add_or_supercede_exported_var (char *assign, int do_alloc)
      strncmp (assign + equal_offset + 2, ") {", 3) == 0)		/* } */
     equal_offset += 4;
 
-  for (i = 0; i < export_env_index; i++)
+  if (export_env_nslots == 0)
+    export_env_make_index ();
+
+  /* Any entry that matches has the same name up to the first `=', so it is
+     in this probe sequence.  Supersede the first one in EXPORT_ENV, as a
+     linear search would. */
+  mask = export_env_nslots - 1;
+  for (i = -1, h = export_env_hash (assign) & mask; (ind = export_env_slots[h]); h = (h + 1) & mask)
+    if ((i < 0 || ind - 1 < (size_t)i) && STREQN (assign, export_env[ind - 1], equal_offset + 1))
+      i = ind - 1;
+
+  if (i >= 0)
     {
-      if (STREQN (assign, export_env[i], equal_offset + 1))
-	{
-	  free (export_env[i]);
-	  export_env[i] = do_alloc ? savestring (assign) : assign;
-	  return (export_env);
-	}
+      free (export_env[i]);
+      export_env[i] = do_alloc ? savestring (assign) : assign;
+      return (export_env);
     }
   add_to_export_env (assign, do_alloc);
   return (export_env);
@@ -5072,6 +5447,8 @@ maybe_make_export_env (void)
     {
       if (export_env)
 	strvec_flush (export_env);
+      /* The name index is rebuilt on demand for the new environment. */
+      export_env_nslots = 0;
 
       /* Make a guess based on how many shell variables and functions we
 	 have.  Since there will always be array variables, and array
@@ -5758,7 +6135,9 @@ struct name_and_function {
 
 static struct name_and_function special_vars[] = {
   { "BASH_COMPAT", sv_shcompat },
+  { "BASH_PROFILE", sv_bash_profile },
   { "BASH_XTRACEFD", sv_xtracefd },
+  { "BASH_XTRACEOPTS", sv_xtraceopts },
 
 #if defined (JOB_CONTROL)
   { "CHILD_MAX", sv_childmax },
@@ -6313,6 +6692,9 @@ set_pipestatus_array (int *ps, int nproc)
       return;
     }
 
+  /* The elements are modified in place below. */
+  ARRAY_UNSHARE (a);
+
   /* Fast case */
   if (array_num_elements (a) == nproc && nproc == 1)
     {
@@ -6454,6 +6836,45 @@ sv_xtracefd (const char *name)
     }
 }
 
+/* BASH_XTRACEOPTS is a colon-separated list of options for set -x output:
+   `json' to write each trace record as a line of JSON instead of
+   expanding PS4, and `buffered' to buffer output to BASH_XTRACEFD. */
+void
+sv_xtraceopts (const char *name)
+{
+  char *t, *opt;
+  int ind, json, buffered;
+
+  json = buffered = 0;
+  t = get_string_value (name);
+  ind = 0;
+  while (t && (opt = extract_colon_unit (t, &ind)))
+    {
+      if (STREQ (opt, "json"))
+	json = 1;
+      else if (STREQ (opt, "buffered"))
+	buffered = 1;
+      else if (*opt)
+	internal_error (_("%s: %s: invalid trace option"), name, opt);
+      free (opt);
+    }
+  xtrace_set_options (json, buffered);
+}
+
+void
+sv_bash_profile (const char *name)
+{
+  SHELL_VAR *v;
+  char *t;
+
+  v = find_variable (name);
+  t = v ? value_cell (v) : (char *)NULL;
+  if (t == 0 || *t == 0)
+    profile_stop ();
+  else
+    profile_start (t);
+}
+
 #define MIN_COMPAT_LEVEL 31
 
 void
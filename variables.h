@@ -98,6 +98,8 @@ typedef struct _vlist {
   SHELL_VAR **list;
   size_t list_size;	/* allocated size */
   size_t list_len;	/* current number of entries */
+  size_t *index;	/* hash of names to list positions, or NULL */
+  size_t index_size;	/* number of slots in index; a power of two */
 } VARLIST;
 
 /* The various attributes that a given variable can have. */
@@ -135,6 +137,7 @@ typedef struct _vlist {
 #define att_special	0x0010000	/* requires special handling */
 #define att_nofree	0x0020000	/* do not free value on unset */
 #define att_regenerate	0x0040000	/* regenerate when exported */
+#define att_unparsed	0x0080000	/* imported function not yet parsed */
 
 #define	attmask_int	0x00ff000
 
@@ -164,6 +167,7 @@ typedef struct _vlist {
 #define specialvar_p(var)	((((var)->attributes) & (att_special)))
 #define nofree_p(var)		((((var)->attributes) & (att_nofree)))
 #define regen_p(var)		((((var)->attributes) & (att_regenerate)))
+#define unparsed_p(var)		((((var)->attributes) & (att_unparsed)))
 
 #define tempvar_p(var)		((((var)->attributes) & (att_tempvar)))
 #define propagate_p(var)	((((var)->attributes) & (att_propagate)))
@@ -282,6 +286,7 @@ extern void make_funcname_visible (int);
 extern SHELL_VAR *var_lookup (const char *, VAR_CONTEXT *);
 
 extern SHELL_VAR *find_function (const char *);
+extern SHELL_VAR *find_function_noimport (const char *);
 extern FUNCTION_DEF *find_function_def (const char *);
 extern SHELL_VAR *find_variable (const char *);
 extern SHELL_VAR *find_variable_noref (const char *);
@@ -300,6 +305,7 @@ extern SHELL_VAR *find_tempenv_variable (const char *);
 extern SHELL_VAR *find_variable_no_invisible (const char *);
 extern SHELL_VAR *find_variable_for_assignment (const char *);
 extern char *nameref_transform_name (const char *, int);
+extern SHELL_VAR *new_shell_variable (const char *);
 extern SHELL_VAR *copy_variable (SHELL_VAR *);
 extern SHELL_VAR *make_local_variable (const char *, int);
 extern SHELL_VAR *bind_variable (const char *, const char *, int);
@@ -451,6 +457,8 @@ extern void sv_optind (const char *);
 extern void sv_opterr (const char *);
 extern void sv_locale (const char *);
 extern void sv_xtracefd (const char *);
+extern void sv_xtraceopts (const char *);
+extern void sv_bash_profile (const char *);
 extern void sv_shcompat (const char *);
 extern void sv_globsort (const char *);
 
@@ -50,6 +50,12 @@ static int brkfound;
 static size_t allocated;
 #endif
 
+/* Calls to the allocation functions in this file and the number of bytes
+   they requested, reported through $BASH_STATS.  Direct calls to malloc
+   and realloc are not counted. */
+unsigned long xmalloc_ncalls;
+unsigned long xmalloc_nbytes;
+
 /* **************************************************************** */
 /*								    */
 /*		   Memory Allocation and Deallocation.		    */
@@ -100,6 +106,8 @@ xmalloc (size_t bytes)
     internal_warning("xmalloc: size argument is 0");
 #endif
 
+  xmalloc_ncalls++;
+  xmalloc_nbytes += bytes;
   FINDBRK();
   temp = malloc (bytes);
 
@@ -119,6 +127,8 @@ xrealloc (PTR_T pointer, size_t bytes)
     internal_warning("xrealloc: size argument is 0");
 #endif
 
+  xmalloc_ncalls++;
+  xmalloc_nbytes += bytes;
   FINDBRK();
   temp = pointer ? realloc (pointer, bytes) : malloc (bytes);
 
@@ -177,6 +187,8 @@ sh_xmalloc (size_t bytes, char *file, int line)
     internal_warning("xmalloc: %s:%d: size argument is 0", file, line);
 #endif
 
+  xmalloc_ncalls++;
+  xmalloc_nbytes += bytes;
   FINDBRK();
   temp = sh_malloc (bytes, file, line);
 
@@ -196,6 +208,8 @@ sh_xrealloc (PTR_T pointer, size_t bytes, char *file, int line)
     internal_warning("xrealloc: %s:%d: size argument is 0", file, line);
 #endif
 
+  xmalloc_ncalls++;
+  xmalloc_nbytes += bytes;
   FINDBRK();
   temp = pointer ? sh_realloc (pointer, bytes, file, line) : sh_malloc (bytes, file, line);
 
@@ -35,6 +35,8 @@ extern PTR_T xrealloc (void *, size_t);
 extern PTR_T xreallocarray (void *, size_t, size_t);
 extern void xfree (void *);
 
+extern unsigned long xmalloc_ncalls, xmalloc_nbytes;
+
 #if defined(USING_BASH_MALLOC) && !defined (DISABLE_MALLOC_WRAPPERS)
 extern PTR_T sh_xmalloc (size_t, const char *, int);
 extern PTR_T sh_xrealloc (void *, size_t, const char *, int);